@@ -0,0 +1,122 @@
+#include "ApproachDirectionGoal.h"
+#include "DroneStateConstraintSampler.h"
+#include "thread_rng.h"
+
+/// Number of valid approaches remembered per apple.
+const size_t MAX_SEEDS = 32;
+
+/// Standard deviations of the perturbation applied to a seed.
+const double SEED_YAW_STDDEV = 0.2;
+const double SEED_JOINT_STDDEV = 0.1;
+
+/// Index of the first arm joint variable; the variables before it belong to the floating base.
+const size_t FIRST_ARM_VARIABLE = 7;
+
+ApproachDirectionGoal::ApproachDirectionGoal(const ompl::base::SpaceInformationPtr &si,
+											 double radius,
+											 const Apple &apple,
+											 double explorationProbability)
+		: DroneEndEffectorNearTarget(si, radius, apple.center),
+		  branch_normal(apple.branch_normal.squaredNorm() > 0.0 ? apple.branch_normal.normalized() : Eigen::Vector3d::Zero()),
+		  exploration_probability(explorationProbability) {
+}
+
+void ApproachDirectionGoal::sampleConfiguration(moveit::core::RobotState &st) const {
+
+	auto &rng = thread_rng();
+
+	std::unique_lock<std::mutex> lock(seeds_mutex);
+
+	if (seeds.empty() || rng.uniform01() < exploration_probability) {
+		lock.unlock();
+		// The base is moved to the target afterwards, so its position does not matter.
+		randomizeUprightWithBase(st, 0.0);
+		return;
+	}
+
+	// A copy, since another thread may replace the seed while we use it.
+	const Seed seed = seeds[rng.uniformInt(0, (int) seeds.size() - 1)];
+
+	lock.unlock();
+
+	double *pos = st.getVariablePositions();
+
+	Eigen::Quaterniond q(Eigen::AngleAxisd(seed.yaw + rng.gaussian(0.0, SEED_YAW_STDDEV), Eigen::Vector3d::UnitZ()));
+	pos[3] = q.x();
+	pos[4] = q.y();
+	pos[5] = q.z();
+	pos[6] = q.w();
+
+	for (size_t i = 0; i < seed.arm_joints.size(); ++i) {
+		pos[FIRST_ARM_VARIABLE + i] = seed.arm_joints[i] + rng.gaussian(0.0, SEED_JOINT_STDDEV);
+	}
+
+	// The perturbation may push the joints out of their limits.
+	st.enforceBounds();
+	st.update(true);
+}
+
+bool ApproachDirectionGoal::isOutwardFacing(const moveit::core::RobotState &st) const {
+	const double *pos = st.getVariablePositions();
+	return (Eigen::Vector3d(pos[0], pos[1], pos[2]) - getTarget()).dot(branch_normal) >= 0.0;
+}
+
+void ApproachDirectionGoal::addSeed(const moveit::core::RobotState &st) const {
+
+	const double *pos = st.getVariablePositions();
+
+	// The base is upright, so its orientation is a pure rotation about the Z axis.
+	Seed seed{2.0 * std::atan2(pos[5], pos[6]),
+			  std::vector<double>(pos + FIRST_ARM_VARIABLE, pos + st.getVariableCount())};
+
+	std::lock_guard<std::mutex> lock(seeds_mutex);
+
+	if (seeds.size() < MAX_SEEDS) {
+		seeds.push_back(std::move(seed));
+	} else {
+		seeds[next_seed_slot] = std::move(seed);
+		next_seed_slot = (next_seed_slot + 1) % MAX_SEEDS;
+	}
+}
+
+bool ApproachDirectionGoal::sampleGoalLive(ompl::base::State *state) const {
+	auto *state_space = si_->getStateSpace()->as<DroneStateSpace>();
+
+	moveit::core::RobotState st(state_space->getRobotModel());
+
+	const size_t ATTEMPTS_BEFORE_GIVE_UP = 100;
+
+	for (size_t attempt = 0; attempt < ATTEMPTS_BEFORE_GIVE_UP; ++attempt) {
+
+		sampleConfiguration(st);
+		moveEndEffectorToGoal(st, getRadius(), getTarget());
+		samples_tried += 1;
+
+		// Reject approaches from behind the branch without paying for a collision check.
+		if (!isOutwardFacing(st)) {
+			continue;
+		}
+
+		state_space->copyToOMPLState(state, st);
+
+		if (si_->isValid(state)) {
+			assert(this->isSatisfied(state));
+			addSeed(st);
+			samples_yielded += 1;
+			return true;
+		}
+	}
+
+	OMPL_WARN("Goal sampling failed after %d attempts. Giving up.", ATTEMPTS_BEFORE_GIVE_UP);
+
+	return false;
+}
+
+double ApproachDirectionGoal::getYield() const {
+	return samples_tried == 0 ? 0.0 : (double) samples_yielded / (double) samples_tried;
+}
+
+size_t ApproachDirectionGoal::getSeedCount() const {
+	std::lock_guard<std::mutex> lock(seeds_mutex);
+	return seeds.size();
+}
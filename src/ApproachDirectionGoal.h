@@ -0,0 +1,70 @@
+#ifndef NEW_PLANNERS_APPROACHDIRECTIONGOAL_H
+#define NEW_PLANNERS_APPROACHDIRECTIONGOAL_H
+
+#include <mutex>
+#include "ompl_custom.h"
+#include "procedural_tree_generation.h"
+
+/**
+ * A DroneEndEffectorNearTarget that learns, per apple, which approaches are collision-free.
+ *
+ * Every goal sample that turns out to be valid is remembered as a seed: the yaw of the base and the arm joint values.
+ * Later samples are mostly drawn near a random seed (Gaussian in yaw and joints), and only occasionally uniformly,
+ * such that sampling concentrates on the (often small) set of approaches that reach into the canopy without hitting
+ * branches, while still discovering new ones.
+ *
+ * Samples where the drone's base is on the branch side of the apple (judging by Apple::branch_normal) are rejected
+ * before the (expensive) collision check, since those essentially always collide with the branch.
+ */
+class ApproachDirectionGoal : public DroneEndEffectorNearTarget {
+
+	/// A configuration that yielded a valid goal sample, relative to the target.
+	struct Seed {
+		double yaw;
+		std::vector<double> arm_joints;
+	};
+
+	/// Unit vector pointing away from the branch the apple hangs on; zero if unknown.
+	Eigen::Vector3d branch_normal;
+
+	/// Probability of sampling uniformly rather than near a seed, once there are seeds.
+	double exploration_probability;
+
+	/// Guards `seeds` and `next_seed_slot`, since goal samples may be drawn from several threads at once.
+	mutable std::mutex seeds_mutex;
+
+	mutable std::vector<Seed> seeds;
+
+	/// Where the next seed goes once `seeds` is full; the oldest seeds are replaced first.
+	mutable size_t next_seed_slot = 0;
+
+	/// Randomize the yaw and arm joints of the state, either uniformly or near a seed.
+	void sampleConfiguration(moveit::core::RobotState &st) const;
+
+	/// Whether the base of the drone is on the outward side of the apple.
+	[[nodiscard]] bool isOutwardFacing(const moveit::core::RobotState &st) const;
+
+	void addSeed(const moveit::core::RobotState &st) const;
+
+public:
+	/**
+	 * @param si 						The space information.
+	 * @param radius 					Maximum distance between the end-effector and the apple.
+	 * @param apple 					The apple to reach.
+	 * @param explorationProbability 	Probability of sampling uniformly rather than near a previous valid sample.
+	 */
+	ApproachDirectionGoal(const ompl::base::SpaceInformationPtr &si,
+						  double radius,
+						  const Apple &apple,
+						  double explorationProbability = 0.2);
+
+	bool sampleGoalLive(ompl::base::State *state) const override;
+
+	/// The fraction of samples tried that yielded a valid goal state.
+	[[nodiscard]] double getYield() const;
+
+	/// The number of remembered valid approaches.
+	[[nodiscard]] size_t getSeedCount() const;
+};
+
+#endif //NEW_PLANNERS_APPROACHDIRECTIONGOAL_H
@@ -0,0 +1,103 @@
+#include "ApproachPathCache.h"
+#include "json_utils.h"
+
+#include <filesystem>
+#include <sstream>
+
+std::string ApproachPathCache::Key::toString() const {
+	std::stringstream ss;
+	ss << scene_hash << "/" << apple_index << "/" << planner_parameters;
+	return ss.str();
+}
+
+std::optional<ompl::geometric::PathGeometric>
+ApproachPathCache::lookup(const ApproachPathCache::Key &key, const ompl::base::SpaceInformationPtr &si) const {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto fnd = paths.find(key.toString());
+
+	if (fnd == paths.end()) {
+		misses += 1;
+		return {};
+	}
+
+	hits += 1;
+
+	ompl::geometric::PathGeometric path(si);
+
+	ompl::base::ScopedState<> state(si);
+	for (const auto &reals: fnd->second) {
+		si->getStateSpace()->copyFromReals(state.get(), reals);
+		path.append(state.get());
+	}
+
+	return {path};
+}
+
+void ApproachPathCache::store(const ApproachPathCache::Key &key, const ompl::geometric::PathGeometric &path) {
+
+	// Do the conversion outside the lock.
+	std::vector<std::vector<double>> reals(path.getStateCount());
+	for (size_t i = 0; i < path.getStateCount(); ++i) {
+		path.getSpaceInformation()->getStateSpace()->copyToReals(reals[i], path.getState(i));
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	paths[key.toString()] = std::move(reals);
+}
+
+void ApproachPathCache::load(const std::string &filename) {
+
+	if (!std::filesystem::exists(filename)) {
+		return;
+	}
+
+	Json::Value json = jsonFromGzipFile(filename);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (const auto &key: json.getMemberNames()) {
+		std::vector<std::vector<double>> reals;
+		for (const auto &state_json: json[key]) {
+			reals.emplace_back();
+			for (const auto &value: state_json) {
+				reals.back().push_back(value.asDouble());
+			}
+		}
+		paths[key] = std::move(reals);
+	}
+}
+
+void ApproachPathCache::save(const std::string &filename) const {
+
+	Json::Value json(Json::objectValue);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (const auto &[key, reals]: paths) {
+			Json::Value path_json(Json::arrayValue);
+			for (const auto &state_reals: reals) {
+				Json::Value state_json(Json::arrayValue);
+				for (double value: state_reals) {
+					state_json.append(value);
+				}
+				path_json.append(state_json);
+			}
+			json[key] = path_json;
+		}
+	}
+
+	jsonToGzipFile(json, filename);
+}
+
+Json::Value ApproachPathCache::statistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Json::Value stats;
+	stats["entries"] = (Json::UInt64) paths.size();
+	stats["hits"] = (Json::UInt64) hits;
+	stats["misses"] = (Json::UInt64) misses;
+	return stats;
+}
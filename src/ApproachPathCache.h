@@ -0,0 +1,75 @@
+#ifndef NEW_PLANNERS_APPROACHPATHCACHE_H
+#define NEW_PLANNERS_APPROACHPATHCACHE_H
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/geometric/PathGeometric.h>
+#include <jsoncpp/json/value.h>
+
+/**
+ * A thread-safe cache of approach paths (shell state to apple), which do not depend on the start state
+ * of the robot, and hence can be reused between runs that visit the same apples in the same scene.
+ *
+ * Paths are stored as plain arrays of reals (see ompl::base::StateSpace::copyToReals), such that
+ * the cache can be shared between workers that each have their own SpaceInformation, and persisted to disk.
+ */
+class ApproachPathCache {
+
+public:
+	/**
+	 * Identifies an approach path: paths are only reused for the same apple in the same scene,
+	 * planned with the same planner parameters.
+	 */
+	struct Key {
+		/// See sceneHash()
+		size_t scene_hash;
+		/// Index of the apple in AppleTreePlanningScene::apples
+		size_t apple_index;
+		/// Serialized parameters of the planner that produced the path.
+		std::string planner_parameters;
+
+		[[nodiscard]] std::string toString() const;
+	};
+
+private:
+	/// Cached paths, by Key::toString().
+	std::unordered_map<std::string, std::vector<std::vector<double>>> paths;
+
+	/// Guards `paths`
+	mutable std::mutex mutex;
+
+	/// Number of lookups that hit/missed, for statistics.
+	mutable size_t hits = 0, misses = 0;
+
+public:
+	/**
+	 * Look up a path, converting it to the state space of the given SpaceInformation.
+	 */
+	std::optional<ompl::geometric::PathGeometric> lookup(const Key &key, const ompl::base::SpaceInformationPtr &si) const;
+
+	/**
+	 * Store a path, replacing any path stored under the same key.
+	 */
+	void store(const Key &key, const ompl::geometric::PathGeometric &path);
+
+	/**
+	 * Load the cache from a file written by save(). Entries in the file are added to the cache.
+	 * Does nothing if the file does not exist.
+	 */
+	void load(const std::string &filename);
+
+	/**
+	 * Persist the cache to a (gzipped JSON) file.
+	 */
+	void save(const std::string &filename) const;
+
+	/**
+	 * Lookup hit/miss counts.
+	 */
+	[[nodiscard]] Json::Value statistics() const;
+
+};
+
+#endif //NEW_PLANNERS_APPROACHPATHCACHE_H
@@ -1,14 +1,14 @@
 #include "procedural_tree_generation.h"
 #include <moveit/robot_state/conversions.h>
 #include <Eigen/Geometry>
-#include <random_numbers/random_numbers.h>
 #include "DroneStateConstraintSampler.h"
+#include "DroneStateView.h"
+#include "thread_rng.h"
 
 
 void moveEndEffectorToGoal(moveit::core::RobotState &state, double tolerance, const Eigen::Vector3d &target) {
 
-	// Get the Rng
-	random_numbers::RandomNumberGenerator rng;
+	auto &rng = thread_rng();
 
 	// Sample a distance from the target to the end-effector uniformly between 0 (included) and tolerance (excluded)
 	double sample_radius = tolerance * rng.uniformReal(0.0, 1.0 - std::numeric_limits<double>::epsilon());
@@ -38,14 +38,28 @@ void moveEndEffectorToGoal(moveit::core::RobotState &state, double tolerance, co
 	}
 }
 
+void moveEndEffectorToGoal(DroneStateView &state, double tolerance, const Eigen::Vector3d &target) {
+
+	auto &rng = thread_rng();
+
+	double sample_radius = tolerance * rng.uniformReal(0.0, 1.0 - std::numeric_limits<double>::epsilon());
+
+	Eigen::Vector3d delta = target - state.linkTransform("end_effector").translation();
+
+	double norm = delta.norm();
+
+	if (norm > sample_radius) {
+		state.translateBase(delta * ((norm - sample_radius) / norm));
+	}
+}
+
 void randomizeUprightWithBase(moveit::core::RobotState &state, double translation_bound) {
 
 	// Set the state to uniformly random values.
 	// Unfortunately, this puts the base at the origin and the rotation will not be upright. We need to fix that.
-	state.setToRandomPositions();
+	state.setToRandomPositions(thread_moveit_rng());
 
-	// Get an Rng
-	random_numbers::RandomNumberGenerator rng;
+	auto &rng = thread_rng();
 
 	// Randomize the floating base within a box defined by the translation_bound.
 	double *pos = state.getVariablePositions();
@@ -63,3 +77,36 @@ void randomizeUprightWithBase(moveit::core::RobotState &state, double translatio
 	// Force-update the state. (Since we wrote to its memory it cannot know that it has changed)
 	state.update(true);
 }
+
+void randomizeUprightWithBase(DroneStateView &state, double translation_bound) {
+
+	auto &rng = thread_rng();
+
+	state.setBasePosition({
+		rng.uniformReal(-translation_bound, translation_bound),
+		rng.uniformReal(-translation_bound, translation_bound),
+		rng.uniformReal(0 /* Do not put it underground */, translation_bound)
+	});
+
+	state.setYaw(rng.uniformReal(-M_PI, M_PI));
+
+	for (size_t i = 0; i < state.armJointCount(); ++i) {
+		const auto &bounds = state.armJointBounds(i);
+		state.setArmJoint(i, rng.uniformReal(bounds.min_position_, bounds.max_position_));
+	}
+}
+
+void gaussianNearUpright(DroneStateView &state, const DroneStateView &mean, double stddev) {
+
+	auto &rng = thread_rng();
+
+	state.setBasePosition(mean.basePosition() + Eigen::Vector3d(rng.gaussian(0.0, stddev),
+																rng.gaussian(0.0, stddev),
+																rng.gaussian(0.0, stddev)));
+
+	state.setYaw(mean.yaw() + rng.gaussian(0.0, stddev));
+
+	for (size_t i = 0; i < mean.armJointCount(); ++i) {
+		state.setArmJoint(i, mean.armJoint(i) + rng.gaussian(0.0, stddev));
+	}
+}
@@ -1,6 +1,8 @@
 #ifndef NEW_PLANNERS_DRONESTATECONSTRAINTSAMPLER_H
 #define NEW_PLANNERS_DRONESTATECONSTRAINTSAMPLER_H
 
+class DroneStateView;
+
 /**
  * Computes the end-effector position of a drone given the current state of the drone, then applies a translation
  * to the base such that the end-effector is within `tolerance` distance of the target point. Within this bound,
@@ -12,6 +14,12 @@
  */
 void moveEndEffectorToGoal(moveit::core::RobotState &state, double tolerance, const Eigen::Vector3d &target);
 
+/**
+ * Like moveEndEffectorToGoal on a RobotState, but in place on an OMPL state; since only the base is translated,
+ * forward kinematics runs at most once (and not at all if the view has valid link transforms).
+ */
+void moveEndEffectorToGoal(DroneStateView &state, double tolerance, const Eigen::Vector3d &target);
+
 /**
  *
  * Assuming a drone model, will uniformly sample a robot state, with the following guarantees:
@@ -28,4 +36,15 @@ void moveEndEffectorToGoal(moveit::core::RobotState &state, double tolerance, co
  */
 void randomizeUprightWithBase(moveit::core::RobotState &state, double translation_bound);
 
+/**
+ * Like randomizeUprightWithBase on a RobotState, but in place on an OMPL state, without forward kinematics.
+ */
+void randomizeUprightWithBase(DroneStateView &state, double translation_bound);
+
+/**
+ * Write an upright state near `mean` to `state`: Gaussian noise with the given standard deviation on the translation
+ * of the base, its yaw and the arm joints. The arm joints may end up out of bounds; enforce them afterwards.
+ */
+void gaussianNearUpright(DroneStateView &state, const DroneStateView &mean, double stddev);
+
 #endif //NEW_PLANNERS_DRONESTATECONSTRAINTSAMPLER_H
@@ -1,71 +1,108 @@
 #include "ompl_custom.h"
 #include "DroneStateConstraintSampler.h"
 #include "DroneStateSampler.h"
+#include "DroneStateView.h"
+#include "thread_rng.h"
 
 DroneStateSampler::DroneStateSampler(const ompl::base::StateSpace *space, double translationBound)
 		: StateSampler(space), translation_bound(translationBound) {
 }
 
 void DroneStateSampler::sampleUniform(ompl::base::State *state) {
-	// Allocate a Moveit state
-	moveit::core::RobotState st(space_->as<DroneStateSpace>()->getRobotModel());
 
-	// Sample uniformly.
-	randomizeUprightWithBase(st, translation_bound);
+	auto &rng = thread_rng();
 
-	// Convert and write to the state.
-	space_->as<DroneStateSpace>()->copyToOMPLState(state, st);
+	const auto &layout = space_->as<DroneStateSpace>()->getLayout();
+
+	// Drawn in the same order as a batch of one, such that both give the same states for the same seed.
+	DroneStateView view(*space_->as<DroneStateSpace>(), state);
+
+	const double x = rng.uniformReal(-translation_bound, translation_bound);
+	const double y = rng.uniformReal(-translation_bound, translation_bound);
+	const double z = rng.uniformReal(0.0 /* Do not put it underground */, translation_bound);
+	view.setBasePosition({x, y, z});
+	view.setYaw(rng.uniformReal(-M_PI, M_PI));
+
+	for (size_t arm_i = 0; arm_i < layout.arm.size(); ++arm_i) {
+		view.setArmJoint(arm_i, rng.uniformReal(layout.arm_bounds[arm_i].min_position_, layout.arm_bounds[arm_i].max_position_));
+	}
+}
+
+void DroneStateSampler::sampleUniformBatch(const std::vector<ompl::base::State *> &states) {
+
+	auto &rng = thread_rng();
+
+	const auto &layout = space_->as<DroneStateSpace>()->getLayout();
+
+	// Columns: x, y, z, yaw, followed by the arm joints.
+	const size_t n = states.size();
+	const size_t n_columns = 4 + layout.arm.size();
+
+	columns.resize(n * n_columns);
+
+	auto fill_uniform = [&](size_t column, double lower, double upper) {
+		for (size_t i = 0; i < n; ++i) {
+			columns[column * n + i] = rng.uniformReal(lower, upper);
+		}
+	};
+
+	// As in randomizeUprightWithBase.
+	fill_uniform(0, -translation_bound, translation_bound);
+	fill_uniform(1, -translation_bound, translation_bound);
+	fill_uniform(2, 0.0 /* Do not put it underground */, translation_bound);
+	fill_uniform(3, -M_PI, M_PI);
+
+	for (size_t arm_i = 0; arm_i < layout.arm.size(); ++arm_i) {
+		fill_uniform(4 + arm_i, layout.arm_bounds[arm_i].min_position_, layout.arm_bounds[arm_i].max_position_);
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		DroneStateView view(*space_->as<DroneStateSpace>(), states[i]);
+
+		view.setBasePosition({columns[i], columns[n + i], columns[2 * n + i]});
+		view.setYaw(columns[3 * n + i]);
+
+		for (size_t arm_i = 0; arm_i < layout.arm.size(); ++arm_i) {
+			view.setArmJoint(arm_i, columns[(4 + arm_i) * n + i]);
+		}
+	}
 }
 
 void DroneStateSampler::sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, double distance) {
 
-	// Allocate a Moveit state and convert from OMPL.
-	moveit::core::RobotState nr(space_->as<DroneStateSpace>()->getRobotModel());
-	space_->as<DroneStateSpace>()->copyToRobotState(nr, near);
-	const double *near_pos = nr.getVariablePositions();
+	const auto &space = *space_->as<DroneStateSpace>();
 
-	// Allocate a MoveIt state to write the result to.
-	moveit::core::RobotState out(space_->as<DroneStateSpace>()->getRobotModel());
-	double *out_pos = out.getVariablePositions();
+	const auto nr = DroneStateView::of(space, near);
+	DroneStateView out(space, state);
 
 	// Sanity check to make sure we didn't add or remove any links in the robot.
-	assert(out.getVariableCount() == 11);
+	assert(nr.armJointCount() == 4);
 
 	// Sample a point uniformly in a sphere, then add to the translation of the reference state.
 	std::vector<double> translation_delta(3);
 	rng_.uniformInBall(distance, translation_delta);
-	// Also write it into the result variables.
-	out_pos[0] = near_pos[0] + translation_delta[0];
-	out_pos[1] = near_pos[1] + translation_delta[1];
-	out_pos[2] = near_pos[2] + translation_delta[2];
+	out.setBasePosition(nr.basePosition() + Eigen::Vector3d(translation_delta[0], translation_delta[1], translation_delta[2]));
 
-	// Extract the rotation from the current set of variables.
-	Eigen::Quaterniond current_rot(near_pos[6], near_pos[3], near_pos[4], near_pos[5]);
 	// Add a random yaw-rotation to the reference rotation.
-	Eigen::Quaterniond result_rot =
-			current_rot * Eigen::AngleAxisd(rng_.uniformReal(-distance, distance), Eigen::Vector3d::UnitZ());
-	// Write it into the result.
-	out_pos[3] = result_rot.x();
-	out_pos[4] = result_rot.y();
-	out_pos[5] = result_rot.z();
-	out_pos[6] = result_rot.w();
+	out.setBaseOrientation(
+			nr.baseOrientation() * Eigen::AngleAxisd(rng_.uniformReal(-distance, distance), Eigen::Vector3d::UnitZ()));
 
 	// Add random angles to the arm joints.
-	out_pos[7] = std::clamp(near_pos[7] + rng_.uniformReal(-distance, distance), -1.0, 1.0);
-	out_pos[8] = std::clamp(near_pos[8] + rng_.uniformReal(-distance, distance), -1.0, 1.0);
-	out_pos[9] = std::clamp(near_pos[8] + rng_.uniformReal(-distance, distance), -1.0, 1.0);
-	out_pos[10] = near_pos[10] + rng_.uniformReal(-distance, distance);
-
-	// Force-update
-	out.update(true);
-
-	// Convert to OMPL and write into the result variable.
-	space_->as<DroneStateSpace>()->copyToOMPLState(state, out);
+	for (size_t i = 0; i < 3; ++i) {
+		out.setArmJoint(i, std::clamp(nr.armJoint(i) + rng_.uniformReal(-distance, distance), -1.0, 1.0));
+	}
+	out.setArmJoint(3, nr.armJoint(3) + rng_.uniformReal(-distance, distance));
 
 	// Enforce any relevant joint value bounds.
 	space_->enforceBounds(state);
 }
 
 void DroneStateSampler::sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, double stdDev) {
-	throw std::logic_error("Not implemented DroneStateSampler::sampleGaussian");
+
+	const auto &space = *space_->as<DroneStateSpace>();
+
+	DroneStateView out(space, state);
+	gaussianNearUpright(out, DroneStateView::of(space, mean), stdDev);
+
+	space_->enforceBounds(state);
 }
\ No newline at end of file
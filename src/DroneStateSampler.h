@@ -1,17 +1,22 @@
 #ifndef NEW_PLANNERS_DRONESTATESAMPLER_H
 #define NEW_PLANNERS_DRONESTATESAMPLER_H
 
+#include "batch_sampling.h"
+
 /**
  * A custom sampler for the DroneStateSpace that samples states where the robot is upright,
  * with the translation of the base within a box of size defined by translationBound. (see randomizeUprightWithBase)
  *
  * Assumes we're using the drone robot model.
  */
-class DroneStateSampler : public ompl::base::StateSampler {
+class DroneStateSampler : public ompl::base::StateSampler, public BatchStateSampler {
 
 	// Translation bound to use with randomizeUprightWithBase
 	double translation_bound;
 
+	/// Scratch space for the sampled variables of a batch, one variable after another.
+	std::vector<double> columns;
+
 public:
 	/**
 	 *
@@ -26,6 +31,12 @@ public:
 	 */
 	void sampleUniform(ompl::base::State *state) override;
 
+	/**
+	 * Samples the states uniformly, like sampleUniform; generates the random variables for the whole batch
+	 * first, one variable at a time, and writes them into the states in place (see DroneStateView).
+	 */
+	void sampleUniformBatch(const std::vector<ompl::base::State *> &states) override;
+
 	/**
 	 * Samples a state near another state within a given distance.
 	 *
@@ -36,7 +47,7 @@ public:
 	void sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, double distance) override;
 
 	/**
-	 * Samples a state with a gaussian distribution around another state. (Not implemented!)
+	 * Samples a state with a gaussian distribution around another state (see gaussianNearUpright).
 	 *
 	 * @param state 			The state to be written to.
 	 * @param mean 				The reference state to sample around.
@@ -0,0 +1,80 @@
+#include "DroneStateView.h"
+
+DroneStateView::DroneStateView(const DroneStateSpace &space, ompl::base::State *state)
+		: space(&space),
+		  layout(&space.getLayout()),
+		  values(state->as<DroneStateSpace::StateType>()->values) {
+}
+
+const DroneStateView DroneStateView::of(const DroneStateSpace &space, const ompl::base::State *state) {
+	// Only the const methods can be called on the result, so the state is never written to.
+	return {space, const_cast<ompl::base::State *>(state)};
+}
+
+void DroneStateView::setBasePosition(const Eigen::Vector3d &position) {
+	// Written directly rather than as a translation: the state may be freshly allocated, and hold garbage.
+	// The cached link transforms stay valid, since linkTransform() shifts them by the base position.
+	values[layout->base] = position.x();
+	values[layout->base + 1] = position.y();
+	values[layout->base + 2] = position.z();
+}
+
+void DroneStateView::translateBase(const Eigen::Vector3d &delta) {
+	values[layout->base] += delta.x();
+	values[layout->base + 1] += delta.y();
+	values[layout->base + 2] += delta.z();
+}
+
+void DroneStateView::setBaseOrientation(const Eigen::Quaterniond &orientation) {
+	double *q = values + layout->base + 3;
+	q[0] = orientation.x();
+	q[1] = orientation.y();
+	q[2] = orientation.z();
+	q[3] = orientation.w();
+	fk_valid = false;
+}
+
+void DroneStateView::setYaw(double yaw) {
+	double *q = values + layout->base + 3;
+	q[0] = 0.0;
+	q[1] = 0.0;
+	q[2] = std::sin(yaw / 2.0);
+	q[3] = std::cos(yaw / 2.0);
+	fk_valid = false;
+}
+
+void DroneStateView::setArmJoint(size_t i, double value) {
+	values[layout->arm[i]] = value;
+	fk_valid = false;
+}
+
+double DroneStateView::variable(const std::string &name) const {
+	return values[space->getJointModelGroup()->getVariableGroupIndex(name)];
+}
+
+void DroneStateView::setVariable(const std::string &name, double value) {
+	values[space->getJointModelGroup()->getVariableGroupIndex(name)] = value;
+	fk_valid = false;
+}
+
+Eigen::Isometry3d DroneStateView::linkTransform(const std::string &link) const {
+
+	if (!fk_valid) {
+		if (!fk) {
+			fk.emplace(space->getRobotModel());
+		}
+
+		fk->setJointGroupPositions(space->getJointModelGroup(), values);
+		fk->update();
+
+		fk_base_position = basePosition();
+		fk_valid = true;
+	}
+
+	Eigen::Isometry3d transform = fk->getGlobalLinkTransform(link);
+
+	// The base may have moved since; the whole robot moves along with it.
+	transform.translation() += basePosition() - fk_base_position;
+
+	return transform;
+}
@@ -0,0 +1,98 @@
+#ifndef NEW_PLANNERS_DRONESTATEVIEW_H
+#define NEW_PLANNERS_DRONESTATEVIEW_H
+
+#include <optional>
+#include <Eigen/Geometry>
+#include "ompl_custom.h"
+
+/**
+ * A view of an OMPL state of the DroneStateSpace, for reading and modifying it in place, without converting it
+ * to a moveit::core::RobotState and back (which copies every variable and typically involves forward kinematics).
+ *
+ * Link transforms are only computed when asked for, and cached: moving the base only translates the cached
+ * transforms, while any other change invalidates them.
+ *
+ * The view does not own the state, and should not outlive it. The state must not be modified other than through
+ * the view while the view is in use (or call invalidateTransforms() afterwards).
+ */
+class DroneStateView {
+
+	const DroneStateSpace *space;
+	const DroneStateLayout *layout;
+	double *values;
+
+	/// The state at the time link transforms were last computed, if they are still valid (up to base translation).
+	mutable std::optional<moveit::core::RobotState> fk;
+	mutable bool fk_valid = false;
+
+	/// Position of the base at the time `fk` was computed.
+	mutable Eigen::Vector3d fk_base_position;
+
+public:
+	DroneStateView(const DroneStateSpace &space, ompl::base::State *state);
+
+	/**
+	 * A read-only view of the state.
+	 *
+	 * (The result is const, so only the const methods can be used on it.)
+	 */
+	static const DroneStateView of(const DroneStateSpace &space, const ompl::base::State *state);
+
+	[[nodiscard]] Eigen::Vector3d basePosition() const {
+		return {values[layout->base], values[layout->base + 1], values[layout->base + 2]};
+	}
+
+	void setBasePosition(const Eigen::Vector3d &position);
+
+	/// Move the base; unlike other modifications, this keeps the cached link transforms.
+	void translateBase(const Eigen::Vector3d &delta);
+
+	[[nodiscard]] Eigen::Quaterniond baseOrientation() const {
+		const double *q = values + layout->base + 3;
+		return {q[3], q[0], q[1], q[2]};
+	}
+
+	void setBaseOrientation(const Eigen::Quaterniond &orientation);
+
+	/// The yaw of the base, assuming it is upright.
+	[[nodiscard]] double yaw() const {
+		const double *q = values + layout->base + 3;
+		return 2.0 * std::atan2(q[2], q[3]);
+	}
+
+	/// Make the base upright, with the given yaw.
+	void setYaw(double yaw);
+
+	[[nodiscard]] size_t armJointCount() const {
+		return layout->arm.size();
+	}
+
+	/// The value of the i-th arm joint, in the order of the robot model.
+	[[nodiscard]] double armJoint(size_t i) const {
+		return values[layout->arm[i]];
+	}
+
+	void setArmJoint(size_t i, double value);
+
+	[[nodiscard]] const moveit::core::VariableBounds &armJointBounds(size_t i) const {
+		return layout->arm_bounds[i];
+	}
+
+	/// A variable by name (see moveit::core::RobotModel::getVariableNames); slower than the accessors above.
+	[[nodiscard]] double variable(const std::string &name) const;
+
+	void setVariable(const std::string &name, double value);
+
+	/**
+	 * The transform of the given link in the world frame; the first call after a change other than
+	 * a translation of the base runs forward kinematics.
+	 */
+	[[nodiscard]] Eigen::Isometry3d linkTransform(const std::string &link) const;
+
+	/// Forget the cached link transforms, for when the state was modified other than through this view.
+	void invalidateTransforms() {
+		fk_valid = false;
+	}
+};
+
+#endif //NEW_PLANNERS_DRONESTATEVIEW_H
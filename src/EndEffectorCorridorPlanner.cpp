@@ -0,0 +1,364 @@
+#include "EndEffectorCorridorPlanner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <Eigen/Geometry>
+#include <ompl/base/ScopedState.h>
+#include "DroneStateConstraintSampler.h"
+#include "DroneStateView.h"
+
+namespace {
+
+	/// A node of the corridor search: a voxel for the end-effector, and a yaw bin for the base.
+	struct CorridorNode {
+		VoxelOccupancy::Voxel voxel;
+		int yaw_bin;
+		double cost;
+		uint64_t parent;
+		/// Expanded, or found to be occupied.
+		bool closed;
+	};
+
+	uint64_t nodeKey(const VoxelOccupancy::Voxel &voxel, int yaw_bin) {
+		// 18 bits per axis is plenty for the translation bounds of the drone at any sensible resolution.
+		const int64_t offset = 1 << 17;
+		const uint64_t mask = (1 << 18) - 1;
+
+		return (((uint64_t) (voxel.x() + offset) & mask) << 44) |
+			   (((uint64_t) (voxel.y() + offset) & mask) << 26) |
+			   (((uint64_t) (voxel.z() + offset) & mask) << 8) |
+			   ((uint64_t) yaw_bin & 0xff);
+	}
+
+	/// The end-effector position relative to the base, in the world frame, for an upright base with the given yaw.
+	Eigen::Vector3d armVector(const Eigen::Vector3d &arm_offset, double yaw) {
+		return Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ()) * arm_offset;
+	}
+
+	/// Perturb an invalid state around its current value until it is valid.
+	bool repairState(const ompl::base::SpaceInformation &si,
+					 ompl::base::State *state,
+					 unsigned int attempts,
+					 double stddev) {
+
+		const auto &space = *si.getStateSpace()->as<DroneStateSpace>();
+
+		ompl::base::ScopedState<> mean(si.getStateSpace(), state);
+
+		DroneStateView view(space, state);
+
+		for (unsigned int attempt = 0; attempt < attempts; ++attempt) {
+			gaussianNearUpright(view, DroneStateView::of(space, mean.get()), stddev);
+			si.enforceBounds(state);
+
+			if (si.isValid(state)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// Find a valid state near the midpoint of an invalid motion that splits it into two valid ones,
+	/// and append it to the path.
+	bool bridgeMotion(const ompl::base::SpaceInformation &si,
+					  const ompl::base::State *from,
+					  const ompl::base::State *to,
+					  ompl::geometric::PathGeometric &path,
+					  unsigned int attempts,
+					  double stddev) {
+
+		const auto &space = *si.getStateSpace()->as<DroneStateSpace>();
+
+		ompl::base::ScopedState<> mean(si.getStateSpace());
+		ompl::base::ScopedState<> midpoint(si.getStateSpace());
+		space.interpolate(from, to, 0.5, mean.get());
+
+		DroneStateView view(space, midpoint.get());
+
+		for (unsigned int attempt = 0; attempt < attempts; ++attempt) {
+			gaussianNearUpright(view, DroneStateView::of(space, mean.get()), stddev);
+			si.enforceBounds(midpoint.get());
+
+			if (si.isValid(midpoint.get()) && si.checkMotion(from, midpoint.get()) &&
+				si.checkMotion(midpoint.get(), to)) {
+				path.append(midpoint.get());
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+EndEffectorCorridorPlanner::EndEffectorCorridorPlanner(ompl::base::SpaceInformationPtr si,
+													   std::shared_ptr<const VoxelOccupancy> occupancy,
+													   unsigned int yawBins,
+													   double yawWeight,
+													   double terminalRadius,
+													   unsigned int repairAttempts,
+													   double repairStddev,
+													   size_t maxExpansions)
+		: si(std::move(si)),
+		  occupancy(std::move(occupancy)),
+		  yaw_bins(yawBins),
+		  yaw_weight(yawWeight),
+		  terminal_radius(terminalRadius),
+		  repair_attempts(repairAttempts),
+		  repair_stddev(repairStddev),
+		  max_expansions(maxExpansions) {
+	assert(yaw_bins > 0 && yaw_bins <= 256);
+}
+
+std::optional<ompl::geometric::PathGeometric>
+EndEffectorCorridorPlanner::plan(const ompl::base::State *start,
+								 const DroneEndEffectorNearTarget &goal,
+								 const ompl::base::PlannerTerminationCondition &ptc) const {
+
+	const auto &space = *si->getStateSpace()->as<DroneStateSpace>();
+
+	const auto start_view = DroneStateView::of(space, start);
+
+	const Eigen::Vector3d end_effector = start_view.linkTransform("end_effector").translation();
+	const double yaw = start_view.yaw();
+
+	// The arm is held in this configuration throughout, so the base follows from the end-effector pose.
+	const Eigen::Vector3d arm_offset = armVector(end_effector - start_view.basePosition(), -yaw);
+
+	auto corridor = planCorridor(end_effector, yaw, arm_offset, goal.getTarget(), ptc);
+
+	if (!corridor) {
+		return {};
+	}
+
+	auto path = lift(start, arm_offset, *corridor, ptc);
+
+	if (!path) {
+		return {};
+	}
+
+	// If the last state had to be repaired, the end-effector may have left the goal; move it back.
+	const ompl::base::State *last = path->getState(path->getStateCount() - 1);
+
+	if (!goal.isSatisfied(last)) {
+		ompl::base::ScopedState<> state(si->getStateSpace(), last);
+
+		DroneStateView view(space, state.get());
+		moveEndEffectorToGoal(view, 0.01, goal.getTarget());
+
+		if (!si->isValid(state.get()) || !si->checkMotion(last, state.get())) {
+			return {};
+		}
+
+		path->append(state.get());
+	}
+
+	return path;
+}
+
+std::optional<std::vector<EndEffectorCorridorPlanner::Waypoint>>
+EndEffectorCorridorPlanner::planCorridor(const Eigen::Vector3d &start,
+										 double start_yaw,
+										 const Eigen::Vector3d &arm_offset,
+										 const Eigen::Vector3d &target,
+										 const ompl::base::PlannerTerminationCondition &ptc) const {
+
+	const double resolution = occupancy->getResolution();
+	const double yaw_step = 2.0 * M_PI / yaw_bins;
+
+	auto binYaw = [&](int bin) {
+		return -M_PI + bin * yaw_step;
+	};
+
+	auto isFree = [&](const VoxelOccupancy::Voxel &voxel, int bin) {
+		Eigen::Vector3d ee = occupancy->voxelCenter(voxel);
+		Eigen::Vector3d base = ee - armVector(arm_offset, binYaw(bin));
+
+		if (ee.z() < 0.0 || base.z() < 0.0) {
+			return false;
+		}
+
+		bool near_terminal = (ee - start).norm() < terminal_radius || (ee - target).norm() < terminal_radius;
+
+		if (!near_terminal && occupancy->isOccupied(ee)) {
+			return false;
+		}
+
+		return !occupancy->isOccupied(base) && !occupancy->isOccupied(0.5 * (ee + base));
+	};
+
+	const VoxelOccupancy::Voxel target_voxel = occupancy->voxelAt(target);
+
+	// Straight-line distance between voxel centers; admissible, since moves are between neighbouring voxels.
+	auto heuristic = [&](const VoxelOccupancy::Voxel &voxel) {
+		return (voxel - target_voxel).cast<double>().norm() * resolution;
+	};
+
+	double wrapped_yaw = std::fmod(start_yaw + M_PI, 2.0 * M_PI);
+	if (wrapped_yaw < 0.0) {
+		wrapped_yaw += 2.0 * M_PI;
+	}
+
+	const VoxelOccupancy::Voxel start_voxel = occupancy->voxelAt(start);
+	const int start_bin = (int) std::lround(wrapped_yaw / yaw_step) % (int) yaw_bins;
+	const uint64_t start_key = nodeKey(start_voxel, start_bin);
+
+	std::unordered_map<uint64_t, CorridorNode> nodes;
+
+	typedef std::pair<double, uint64_t> QueueEntry;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> open;
+
+	nodes[start_key] = {start_voxel, start_bin, 0.0, start_key, false};
+	open.emplace(heuristic(start_voxel), start_key);
+
+	std::optional<uint64_t> goal_key;
+	size_t expansions = 0;
+
+	while (!open.empty() && expansions < max_expansions) {
+
+		uint64_t key = open.top().second;
+		open.pop();
+
+		CorridorNode &node = nodes.at(key);
+
+		if (node.closed) {
+			continue;
+		}
+
+		node.closed = true;
+
+		const CorridorNode current = node;
+
+		if (current.voxel == target_voxel) {
+			goal_key = key;
+			break;
+		}
+
+		if (++expansions % 1024 == 0 && ptc) {
+			return {};
+		}
+
+		auto relax = [&](const VoxelOccupancy::Voxel &voxel, int bin, double step_cost) {
+			uint64_t neighbour_key = nodeKey(voxel, bin);
+			double cost = current.cost + step_cost;
+
+			auto fnd = nodes.find(neighbour_key);
+
+			if (fnd == nodes.end()) {
+				if (!isFree(voxel, bin)) {
+					nodes[neighbour_key] = {voxel, bin, 0.0, key, true};
+					return;
+				}
+			} else if (fnd->second.closed || fnd->second.cost <= cost) {
+				return;
+			}
+
+			nodes[neighbour_key] = {voxel, bin, cost, key, false};
+			open.emplace(cost + heuristic(voxel), neighbour_key);
+		};
+
+		for (int dx = -1; dx <= 1; ++dx) {
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dz = -1; dz <= 1; ++dz) {
+					if (dx != 0 || dy != 0 || dz != 0) {
+						VoxelOccupancy::Voxel delta(dx, dy, dz);
+						relax(current.voxel + delta, current.yaw_bin, delta.cast<double>().norm() * resolution);
+					}
+				}
+			}
+		}
+
+		relax(current.voxel, (current.yaw_bin + 1) % (int) yaw_bins, yaw_weight * yaw_step);
+		relax(current.voxel, (current.yaw_bin + (int) yaw_bins - 1) % (int) yaw_bins, yaw_weight * yaw_step);
+	}
+
+	if (!goal_key) {
+		return {};
+	}
+
+	std::vector<CorridorNode> chain;
+	for (uint64_t key = *goal_key;; key = nodes.at(key).parent) {
+		chain.push_back(nodes.at(key));
+		if (key == start_key) {
+			break;
+		}
+	}
+	std::reverse(chain.begin(), chain.end());
+
+	// Only keep the nodes where the corridor turns, since the lifting stage checks the motions in between anyway.
+	std::vector<Waypoint> corridor{{start, start_yaw}};
+
+	for (size_t i = 1; i + 1 < chain.size(); ++i) {
+		const auto &previous = chain[i - 1];
+		const auto &current = chain[i];
+		const auto &next = chain[i + 1];
+
+		if (current.voxel - previous.voxel != next.voxel - current.voxel ||
+			current.yaw_bin != previous.yaw_bin ||
+			next.yaw_bin != current.yaw_bin) {
+			corridor.push_back({occupancy->voxelCenter(current.voxel), binYaw(current.yaw_bin)});
+		}
+	}
+
+	corridor.push_back({target, chain.size() > 1 ? binYaw(chain.back().yaw_bin) : start_yaw});
+
+	return corridor;
+}
+
+std::optional<ompl::geometric::PathGeometric>
+EndEffectorCorridorPlanner::lift(const ompl::base::State *start,
+								 const Eigen::Vector3d &arm_offset,
+								 const std::vector<Waypoint> &corridor,
+								 const ompl::base::PlannerTerminationCondition &ptc) const {
+
+	const auto &space = *si->getStateSpace()->as<DroneStateSpace>();
+
+	ompl::geometric::PathGeometric path(si, start);
+
+	ompl::base::ScopedState<> state(si->getStateSpace());
+
+	// The first waypoint is the start state itself.
+	for (size_t i = 1; i < corridor.size(); ++i) {
+
+		if (ptc) {
+			return {};
+		}
+
+		si->copyState(state.get(), start);
+
+		DroneStateView view(space, state.get());
+		view.setYaw(corridor[i].yaw);
+		view.setBasePosition(corridor[i].end_effector - armVector(arm_offset, corridor[i].yaw));
+
+		if (!si->isValid(state.get()) && !repairState(*si, state.get(), repair_attempts, repair_stddev)) {
+			return {};
+		}
+
+		const ompl::base::State *previous = path.getState(path.getStateCount() - 1);
+
+		if (!si->checkMotion(previous, state.get()) &&
+			!bridgeMotion(*si, previous, state.get(), path, repair_attempts, repair_stddev)) {
+			return {};
+		}
+
+		path.append(state.get());
+	}
+
+	return path;
+}
+
+Json::Value EndEffectorCorridorPlanner::parameters() const {
+	Json::Value params;
+	params["resolution"] = occupancy->getResolution();
+	params["yaw_bins"] = yaw_bins;
+	params["yaw_weight"] = yaw_weight;
+	params["terminal_radius"] = terminal_radius;
+	params["repair_attempts"] = repair_attempts;
+	params["repair_stddev"] = repair_stddev;
+	params["max_expansions"] = (Json::UInt64) max_expansions;
+	return params;
+}
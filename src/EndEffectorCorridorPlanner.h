@@ -0,0 +1,120 @@
+#ifndef NEW_PLANNERS_ENDEFFECTORCORRIDORPLANNER_H
+#define NEW_PLANNERS_ENDEFFECTORCORRIDORPLANNER_H
+
+#include <optional>
+#include <vector>
+#include <Eigen/Core>
+#include <jsoncpp/json/value.h>
+#include <ompl/base/PlannerTerminationCondition.h>
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/geometric/PathGeometric.h>
+#include "VoxelOccupancy.h"
+#include "ompl_custom.h"
+
+/**
+ * A two-stage approach planner that searches the (mostly) low-dimensional part of the problem, moving the end-effector
+ * through a gap in the canopy, in a low-dimensional space, rather than in the full state space of the drone.
+ *
+ * 1. Plan a corridor for the end-effector in 3D plus yaw, with A* over a VoxelOccupancy: the arm is held
+ *    in the configuration of the start state, so the base follows rigidly from the end-effector position and yaw;
+ *    a pose is free if the end-effector, the base and the point halfway between them are in free voxels.
+ * 2. Lift the corridor to full states of the drone, check them (and the motions between them) with
+ *    the validity checker, and repair failures locally by Gaussian perturbation.
+ *
+ * If either stage fails, so does the query; the caller is expected to fall back to a full-dimensional planner
+ * (see SingleGoalPlannerMethods::setCorridorPlanner). Queries do not modify the planner, so it can be shared
+ * between threads if the validity checker can.
+ */
+class EndEffectorCorridorPlanner {
+
+	ompl::base::SpaceInformationPtr si;
+
+	std::shared_ptr<const VoxelOccupancy> occupancy;
+
+	/// Number of discrete yaw values in the corridor search.
+	unsigned int yaw_bins;
+
+	/// Cost of rotating the base by one radian, relative to moving the end-effector by one meter.
+	double yaw_weight;
+
+	/// Distance to the start and the target within which the end-effector may be in an occupied voxel,
+	/// since the target typically hangs right next to a branch; the lifted states are checked in full anyway.
+	double terminal_radius;
+
+	/// Number of perturbations to try for every state or motion that fails in the lifting stage.
+	unsigned int repair_attempts;
+
+	/// Standard deviation of those perturbations (see gaussianNearUpright).
+	double repair_stddev;
+
+	/// Maximum number of A* expansions before giving up on a corridor.
+	size_t max_expansions;
+
+public:
+	/// A pose along the corridor.
+	struct Waypoint {
+		Eigen::Vector3d end_effector;
+		double yaw;
+	};
+
+	/**
+	 * @param si 				The space information; the space must be a DroneStateSpace.
+	 * @param occupancy 		The obstacles to plan the corridor around (typically the trunk, inflated by a clearance).
+	 * @param yawBins 			Number of discrete yaw values in the corridor search.
+	 * @param yawWeight 		Cost of rotating the base by one radian, relative to moving the end-effector by one meter.
+	 * @param terminalRadius 	Distance to the start and the target within which the end-effector is not checked for occupancy.
+	 * @param repairAttempts 	Number of perturbations to try for every state or motion that fails after lifting.
+	 * @param repairStddev 		Standard deviation of those perturbations.
+	 * @param maxExpansions 	Maximum number of A* expansions.
+	 */
+	EndEffectorCorridorPlanner(ompl::base::SpaceInformationPtr si,
+							   std::shared_ptr<const VoxelOccupancy> occupancy,
+							   unsigned int yawBins = 16,
+							   double yawWeight = 0.2,
+							   double terminalRadius = 0.2,
+							   unsigned int repairAttempts = 20,
+							   double repairStddev = 0.1,
+							   size_t maxExpansions = 200000);
+
+	/**
+	 * Plan from the start state to a state with the end-effector at the target of the goal.
+	 *
+	 * The start state is assumed to be upright (as are all states from DroneStateSampler).
+	 *
+	 * @return The path, or nothing if no corridor was found or it could not be lifted.
+	 */
+	[[nodiscard]] std::optional<ompl::geometric::PathGeometric> plan(const ompl::base::State *start,
+																	 const DroneEndEffectorNearTarget &goal,
+																	 const ompl::base::PlannerTerminationCondition &ptc) const;
+
+	/**
+	 * The first stage: an A* search for a corridor of end-effector poses.
+	 *
+	 * @param start 		The end-effector position of the start state.
+	 * @param start_yaw 	The yaw of the start state.
+	 * @param arm_offset 	The end-effector position relative to the base, in the frame of the base (held constant).
+	 * @param target 		The end-effector position to end at.
+	 * @param ptc 			Checked every so many expansions.
+	 * @return 				The corridor, from start to target (both exact), or nothing if there is none.
+	 */
+	[[nodiscard]] std::optional<std::vector<Waypoint>> planCorridor(const Eigen::Vector3d &start,
+																	double start_yaw,
+																	const Eigen::Vector3d &arm_offset,
+																	const Eigen::Vector3d &target,
+																	const ompl::base::PlannerTerminationCondition &ptc) const;
+
+	/**
+	 * The second stage: turn the corridor into a valid path, starting at the given state, with the arm
+	 * in the configuration of that state wherever no repair was needed.
+	 *
+	 * @return The path, or nothing if a state or motion could not be repaired.
+	 */
+	[[nodiscard]] std::optional<ompl::geometric::PathGeometric> lift(const ompl::base::State *start,
+																	 const Eigen::Vector3d &arm_offset,
+																	 const std::vector<Waypoint> &corridor,
+																	 const ompl::base::PlannerTerminationCondition &ptc) const;
+
+	[[nodiscard]] Json::Value parameters() const;
+};
+
+#endif //NEW_PLANNERS_ENDEFFECTORCORRIDORPLANNER_H
@@ -1,5 +1,6 @@
 #include "EndEffectorOnShellGoal.h"
 #include "ompl_custom.h"
+#include "thread_rng.h"
 
 #include <utility>
 
@@ -12,7 +13,7 @@ EndEffectorOnShellGoal::EndEffectorOnShellGoal(const ompl::base::SpaceInformatio
 void EndEffectorOnShellGoal::sampleGoal(ompl::base::State *st) const {
 
 	// Sample a point in R^3 in a gaussian distribution around the focus point.
-	ompl::RNG rng;
+	auto &rng = thread_rng();
 
 	Eigen::Vector3d moved_focus(focus.x() + rng.gaussian(0.0, 0.5),
 								focus.y() + rng.gaussian(0.0, 0.5),
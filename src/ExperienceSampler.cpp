@@ -0,0 +1,49 @@
+#include "ExperienceSampler.h"
+#include "DroneStateConstraintSampler.h"
+#include "DroneStateView.h"
+#include "thread_rng.h"
+
+ExperienceSampler::ExperienceSampler(const ompl::base::StateSpace *space,
+									 std::shared_ptr<const ExperienceStore::SceneStates> experience,
+									 ompl::base::StateSamplerPtr base,
+									 double bandwidth,
+									 double baseProbability)
+		: StateSampler(space),
+		  experience(std::move(experience)),
+		  base(std::move(base)),
+		  bandwidth(bandwidth),
+		  base_probability(baseProbability),
+		  kernel_center(space->allocState()) {
+}
+
+ExperienceSampler::~ExperienceSampler() {
+	space_->freeState(kernel_center);
+}
+
+void ExperienceSampler::sampleUniform(ompl::base::State *state) {
+
+	auto &rng = thread_rng();
+
+	if (!experience || experience->empty() || rng.uniform01() < base_probability) {
+		base->sampleUniform(state);
+		return;
+	}
+
+	const auto &reals = (*experience)[rng.uniformInt(0, (int) experience->size() - 1)];
+	space_->copyFromReals(kernel_center, reals);
+
+	const auto &space = *space_->as<DroneStateSpace>();
+
+	DroneStateView out(space, state);
+	gaussianNearUpright(out, DroneStateView::of(space, kernel_center), bandwidth);
+
+	space_->enforceBounds(state);
+}
+
+void ExperienceSampler::sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, double distance) {
+	base->sampleUniformNear(state, near, distance);
+}
+
+void ExperienceSampler::sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, double stdDev) {
+	base->sampleGaussian(state, mean, stdDev);
+}
@@ -0,0 +1,54 @@
+#ifndef NEW_PLANNERS_EXPERIENCESAMPLER_H
+#define NEW_PLANNERS_EXPERIENCESAMPLER_H
+
+#include <ompl/base/StateSampler.h>
+#include "ExperienceStore.h"
+
+/**
+ * Samples from a kernel density estimate over states from previously solved paths in the same scene
+ * (see ExperienceStore), mixed with another sampler (typically uniform) for the parts of the space
+ * that past solutions did not visit.
+ *
+ * A kernel sample picks a stored state uniformly at random, and perturbs it with gaussianNearUpright.
+ */
+class ExperienceSampler : public ompl::base::StateSampler {
+
+	std::shared_ptr<const ExperienceStore::SceneStates> experience;
+
+	/// Sampler for the other part of the mixture.
+	ompl::base::StateSamplerPtr base;
+
+	/// Standard deviation of the Gaussian kernel.
+	double bandwidth;
+
+	/// Probability of sampling from `base` rather than from the kernel density.
+	double base_probability;
+
+	ompl::base::State *kernel_center;
+
+public:
+	/**
+	 * @param space 			The state space; must be a DroneStateSpace.
+	 * @param experience 		The states to place kernels on; if null or empty, all samples come from `base`.
+	 * @param base 				Sampler for the other part of the mixture.
+	 * @param bandwidth 		Standard deviation of the Gaussian kernel.
+	 * @param baseProbability 	Probability of sampling from `base` rather than from the kernel density.
+	 */
+	ExperienceSampler(const ompl::base::StateSpace *space,
+					  std::shared_ptr<const ExperienceStore::SceneStates> experience,
+					  ompl::base::StateSamplerPtr base,
+					  double bandwidth = 0.3,
+					  double baseProbability = 0.3);
+
+	~ExperienceSampler() override;
+
+	void sampleUniform(ompl::base::State *state) override;
+
+	/// Delegates to the base sampler.
+	void sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, double distance) override;
+
+	/// Delegates to the base sampler.
+	void sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, double stdDev) override;
+};
+
+#endif //NEW_PLANNERS_EXPERIENCESAMPLER_H
@@ -0,0 +1,128 @@
+#include "ExperienceStore.h"
+#include "json_utils.h"
+#include "thread_rng.h"
+
+#include <filesystem>
+
+ExperienceStore::ExperienceStore(double spacing, size_t capacity) : spacing(spacing), capacity(capacity) {
+}
+
+void ExperienceStore::add(size_t scene_hash, const ompl::geometric::PathGeometric &path) {
+
+	if (path.getStateCount() == 0) {
+		return;
+	}
+
+	// Resample and convert outside the lock.
+	ompl::geometric::PathGeometric resampled(path);
+	resampled.interpolate(std::max((unsigned int) std::ceil(path.length() / spacing) + 1, (unsigned int) path.getStateCount()));
+
+	std::vector<std::vector<double>> reals(resampled.getStateCount());
+	for (size_t i = 0; i < resampled.getStateCount(); ++i) {
+		resampled.getSpaceInformation()->getStateSpace()->copyToReals(reals[i], resampled.getState(i));
+	}
+
+	auto &rng = thread_rng();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto &scene = scenes[scene_hash];
+
+	// Samplers may still be using the current states.
+	if (scene.states.use_count() > 1) {
+		scene.states = std::make_shared<SceneStates>(*scene.states);
+	}
+
+	for (auto &state: reals) {
+		scene.seen += 1;
+
+		if (scene.states->size() < capacity) {
+			scene.states->push_back(std::move(state));
+		} else {
+			// Keep every state seen so far with equal probability.
+			auto slot = (size_t) (rng.uniform01() * (double) scene.seen);
+			if (slot < capacity) {
+				(*scene.states)[slot] = std::move(state);
+			}
+		}
+	}
+}
+
+std::shared_ptr<const ExperienceStore::SceneStates> ExperienceStore::states(size_t scene_hash) const {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto fnd = scenes.find(scene_hash);
+
+	if (fnd == scenes.end() || fnd->second.states->empty()) {
+		return nullptr;
+	}
+
+	return fnd->second.states;
+}
+
+void ExperienceStore::load(const std::string &filename) {
+
+	if (!std::filesystem::exists(filename)) {
+		return;
+	}
+
+	Json::Value json = jsonFromGzipFile(filename);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (const auto &key: json.getMemberNames()) {
+		Scene scene;
+		scene.seen = json[key]["seen"].asUInt64();
+
+		for (const auto &state_json: json[key]["states"]) {
+			scene.states->emplace_back();
+			for (const auto &value: state_json) {
+				scene.states->back().push_back(value.asDouble());
+			}
+		}
+
+		scenes[std::stoull(key)] = std::move(scene);
+	}
+}
+
+void ExperienceStore::save(const std::string &filename) const {
+
+	Json::Value json(Json::objectValue);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (const auto &[scene_hash, scene]: scenes) {
+			Json::Value states_json(Json::arrayValue);
+			for (const auto &state_reals: *scene.states) {
+				Json::Value state_json(Json::arrayValue);
+				for (double value: state_reals) {
+					state_json.append(value);
+				}
+				states_json.append(state_json);
+			}
+
+			Json::Value scene_json;
+			scene_json["seen"] = (Json::UInt64) scene.seen;
+			scene_json["states"] = states_json;
+			json[std::to_string(scene_hash)] = scene_json;
+		}
+	}
+
+	jsonToGzipFile(json, filename);
+}
+
+Json::Value ExperienceStore::statistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	size_t total = 0;
+	for (const auto &[scene_hash, scene]: scenes) {
+		total += scene.states->size();
+	}
+
+	Json::Value stats;
+	stats["scenes"] = (Json::UInt64) scenes.size();
+	stats["states"] = (Json::UInt64) total;
+	return stats;
+}
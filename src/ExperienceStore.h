@@ -0,0 +1,81 @@
+#ifndef NEW_PLANNERS_EXPERIENCESTORE_H
+#define NEW_PLANNERS_EXPERIENCESTORE_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <ompl/geometric/PathGeometric.h>
+#include <jsoncpp/json/value.h>
+
+/**
+ * A thread-safe store of states from previously solved paths, per scene, such that planners on the same tree
+ * can sample near the corridors that turned out to be passable before (see ExperienceSampler).
+ *
+ * Paths are resampled at a fixed spacing, such that long paths do not dominate the store; once a scene
+ * holds the maximum number of states, new states replace random old ones (reservoir sampling), such that
+ * the store remains a uniform sample of everything it has seen.
+ *
+ * Like ApproachPathCache, states are stored as plain arrays of reals (see ompl::base::StateSpace::copyToReals),
+ * such that the store can be shared between workers that each have their own SpaceInformation, and persisted to disk.
+ */
+class ExperienceStore {
+
+public:
+	/// The states of a single scene; shared with the samplers that use them, and copied before modification.
+	typedef std::vector<std::vector<double>> SceneStates;
+
+private:
+	struct Scene {
+		std::shared_ptr<SceneStates> states = std::make_shared<SceneStates>();
+		/// Number of states offered to the reservoir, including those that were not kept.
+		size_t seen = 0;
+	};
+
+	/// States by scene hash (see sceneHash()).
+	std::unordered_map<size_t, Scene> scenes;
+
+	/// Guards `scenes`.
+	mutable std::mutex mutex;
+
+	/// Distance between consecutive states taken from a path.
+	double spacing;
+
+	/// Maximum number of states per scene.
+	size_t capacity;
+
+public:
+	/**
+	 * @param spacing 	Distance (in the state space metric) between consecutive states taken from a path.
+	 * @param capacity 	Maximum number of states per scene.
+	 */
+	explicit ExperienceStore(double spacing = 0.5, size_t capacity = 10000);
+
+	/**
+	 * Add the states of a solved path in the given scene.
+	 */
+	void add(size_t scene_hash, const ompl::geometric::PathGeometric &path);
+
+	/**
+	 * The states of the given scene, or null if there are none. The result does not change when states are added.
+	 */
+	[[nodiscard]] std::shared_ptr<const SceneStates> states(size_t scene_hash) const;
+
+	/**
+	 * Load the store from a file written by save(). Scenes in the file replace those in the store.
+	 * Does nothing if the file does not exist.
+	 */
+	void load(const std::string &filename);
+
+	/**
+	 * Persist the store to a (gzipped JSON) file.
+	 */
+	void save(const std::string &filename) const;
+
+	/**
+	 * Number of scenes and states.
+	 */
+	[[nodiscard]] Json::Value statistics() const;
+};
+
+#endif //NEW_PLANNERS_EXPERIENCESTORE_H
@@ -0,0 +1,116 @@
+#include "GoalStatePool.h"
+
+#include <atomic>
+#include <thread>
+#include <boost/functional/hash.hpp>
+#include <ompl/base/ScopedState.h>
+
+size_t GoalStatePool::appleKey(const Eigen::Vector3d &target) {
+	size_t seed = 0;
+	boost::hash_combine(seed, target.x());
+	boost::hash_combine(seed, target.y());
+	boost::hash_combine(seed, target.z());
+	return seed;
+}
+
+void GoalStatePool::add(const Eigen::Vector3d &target, const std::vector<double> &reals) {
+	std::lock_guard<std::mutex> lock(mutex);
+	stride = reals.size();
+	auto &apple_states = states[appleKey(target)];
+	apple_states.insert(apple_states.end(), reals.begin(), reals.end());
+}
+
+void GoalStatePool::fill(const std::vector<std::shared_ptr<DroneEndEffectorNearTarget>> &goals,
+						 size_t states_per_goal,
+						 size_t threads,
+						 const ompl::base::PlannerTerminationCondition &ptc) {
+
+	std::atomic<size_t> next_goal{0};
+
+	auto worker = [&]() {
+		for (size_t goal_i = next_goal++; goal_i < goals.size(); goal_i = next_goal++) {
+
+			const auto &goal = goals[goal_i];
+			const auto &si = goal->getSpaceInformation();
+
+			ompl::base::ScopedState<> state(si);
+
+			std::vector<double> reals;
+
+			for (size_t sample_i = 0; sample_i < states_per_goal && !ptc(); ++sample_i) {
+				// The live sampler checks validity itself, and gives up eventually; those samples are dropped.
+				if (goal->sampleGoalLive(state.get())) {
+					si->getStateSpace()->copyToReals(reals, state.get());
+					add(goal->getTarget(), reals);
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t thread_i = 1; thread_i < threads; ++thread_i) {
+		workers.emplace_back(worker);
+	}
+
+	// The calling thread does its share as well.
+	worker();
+
+	for (auto &thread: workers) {
+		thread.join();
+	}
+}
+
+std::future<void> GoalStatePool::fillAsync(std::vector<std::shared_ptr<DroneEndEffectorNearTarget>> goals,
+										   size_t states_per_goal,
+										   size_t threads) {
+	return std::async(std::launch::async, [this, goals = std::move(goals), states_per_goal, threads]() {
+		fill(goals, states_per_goal, threads);
+	});
+}
+
+bool GoalStatePool::take(const DroneEndEffectorNearTarget &goal, ompl::base::State *state) {
+
+	std::vector<double> reals;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto fnd = states.find(appleKey(goal.getTarget()));
+
+		if (fnd == states.end() || fnd->second.empty()) {
+			missed += 1;
+			return false;
+		}
+
+		reals.assign(fnd->second.end() - (long) stride, fnd->second.end());
+		fnd->second.resize(fnd->second.size() - stride);
+		served += 1;
+	}
+
+	goal.getSpaceInformation()->getStateSpace()->copyFromReals(state, reals);
+
+	return true;
+}
+
+size_t GoalStatePool::available(const Eigen::Vector3d &target) const {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto fnd = states.find(appleKey(target));
+
+	return fnd == states.end() || stride == 0 ? 0 : fnd->second.size() / stride;
+}
+
+Json::Value GoalStatePool::statistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	size_t total = 0;
+	for (const auto &[key, apple_states]: states) {
+		total += stride == 0 ? 0 : apple_states.size() / stride;
+	}
+
+	Json::Value stats;
+	stats["available"] = (Json::UInt64) total;
+	stats["served"] = (Json::UInt64) served;
+	stats["missed"] = (Json::UInt64) missed;
+	return stats;
+}
@@ -0,0 +1,87 @@
+#ifndef NEW_PLANNERS_GOALSTATEPOOL_H
+#define NEW_PLANNERS_GOALSTATEPOOL_H
+
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+#include <jsoncpp/json/value.h>
+#include <ompl/base/PlannerTerminationCondition.h>
+#include "ompl_custom.h"
+
+/**
+ * A thread-safe pool of precomputed valid goal states for every apple in a scene, such that goal sampling
+ * (which, inside the canopy, needs many rejection-sampling attempts per valid state) happens up-front
+ * or in the background rather than during every query.
+ *
+ * Goals use the pool through DroneEndEffectorNearTarget::setStatePool; once the pool has no states left
+ * for an apple, they fall back to sampling live.
+ *
+ * States are only valid in the scene they were generated for, so a pool must not be shared between scenes.
+ * Apples are identified by their position, so the pool can be shared between goal objects for the same apple.
+ * States are stored flattened as arrays of reals (see ompl::base::StateSpace::copyToReals).
+ */
+class GoalStatePool {
+
+	/// Valid goal states by apple (see appleKey), one after another.
+	std::unordered_map<size_t, std::vector<double>> states;
+
+	/// Number of reals per state; 0 until the first state is added.
+	size_t stride = 0;
+
+	/// Guards `states`, `stride` and the statistics.
+	mutable std::mutex mutex;
+
+	/// Number of requests that were served from the pool, and that found it empty.
+	size_t served = 0, missed = 0;
+
+	static size_t appleKey(const Eigen::Vector3d &target);
+
+	void add(const Eigen::Vector3d &target, const std::vector<double> &reals);
+
+public:
+	/**
+	 * Generate valid goal states for every goal with DroneEndEffectorNearTarget::sampleGoalLive, and add them to the pool.
+	 *
+	 * Goals are divided over the given number of threads; every goal is only sampled from by a single thread,
+	 * but validity checks run concurrently, so the validity checker must be thread-safe.
+	 *
+	 * @param goals 			The goals to generate states for.
+	 * @param states_per_goal 	How many samples to attempt per goal; invalid samples are dropped.
+	 * @param threads 			Number of threads to use.
+	 * @param ptc 				Stops generating (without throwing) when it triggers.
+	 */
+	void fill(const std::vector<std::shared_ptr<DroneEndEffectorNearTarget>> &goals,
+			  size_t states_per_goal,
+			  size_t threads,
+			  const ompl::base::PlannerTerminationCondition &ptc = ompl::base::plannerNonTerminatingCondition());
+
+	/**
+	 * Like fill(), but in the background; the pool can be used (and will grow) in the mean time.
+	 *
+	 * The goals are kept alive until filling completes.
+	 */
+	std::future<void> fillAsync(std::vector<std::shared_ptr<DroneEndEffectorNearTarget>> goals,
+								size_t states_per_goal,
+								size_t threads);
+
+	/**
+	 * Take a state for the given goal out of the pool.
+	 *
+	 * @return Whether there was a state left to write to `state`.
+	 */
+	bool take(const DroneEndEffectorNearTarget &goal, ompl::base::State *state);
+
+	/**
+	 * Number of states left for the apple at the given position.
+	 */
+	[[nodiscard]] size_t available(const Eigen::Vector3d &target) const;
+
+	/**
+	 * Total number of states left, and how many requests were served from the pool or found it empty.
+	 */
+	[[nodiscard]] Json::Value statistics() const;
+};
+
+#endif //NEW_PLANNERS_GOALSTATEPOOL_H
@@ -1,4 +1,7 @@
 #include "GreatCircleMetric.h"
+#include "distance_kernels.h"
+
+#include <memory>
 
 GreatCircleMetric::GreatCircleMetric(Eigen::Vector3d sphereCenter) : sphere_center(std::move(sphereCenter)) {}
 
@@ -11,4 +14,23 @@ double GreatCircleMetric::measure(const Eigen::Vector3d &a, const Eigen::Vector3
 	// Compute the angle between the two vectors.
     return acos(na.dot(nb));
 
-}
\ No newline at end of file
+}
+const Eigen::Vector3d &GreatCircleMetric::getSphereCenter() const {
+	return sphere_center;
+}
+
+std::vector<double> GreatCircleMetric::measure_from(const Eigen::Vector3d &a, const std::vector<Eigen::Vector3d> &points) const {
+
+	std::vector<double> result(points.size());
+	great_circle_angles((a - sphere_center).normalized(), PointsSoA::directions_from(points, sphere_center), result.data());
+	return result;
+}
+
+std::function<void(size_t, double *)> GreatCircleMetric::measure_rows(const std::vector<Eigen::Vector3d> &points) const {
+
+	auto directions = std::make_shared<PointsSoA>(PointsSoA::directions_from(points, sphere_center));
+
+	return [directions](size_t i, double *out) {
+		great_circle_angles({directions->x[i], directions->y[i], directions->z[i]}, *directions, out);
+	};
+}
@@ -2,6 +2,8 @@
 #define NEW_PLANNERS_GREATCIRCLEMETRIC_H
 
 #include <Eigen/Geometry>
+#include <functional>
+#include <vector>
 
 /**
  * Helper struct to calculate great-circle distance between two points,
@@ -29,6 +31,26 @@ public:
 	 * @return 		The distance.
 	 */
 	[[nodiscard]] double measure(const Eigen::Vector3d &a, const Eigen::Vector3d &b) const;
+
+	/**
+	 * Calculate the great-circle distance from one point to many.
+	 *
+	 * @param a 		The first point.
+	 * @param points 	The other points.
+	 * @return 			The distance from a to every point, in the same order.
+	 */
+	[[nodiscard]] std::vector<double> measure_from(const Eigen::Vector3d &a, const std::vector<Eigen::Vector3d> &points) const;
+
+	/**
+	 * Produce a function that, given an index i, writes the distance from points[i] to every point into an output array.
+	 *
+	 * The points are normalized once up-front, rather than twice per pair as in measure(). The function is thread-safe.
+	 *
+	 * @param points 	The points; copied, so they need not outlive the function.
+	 */
+	[[nodiscard]] std::function<void(size_t, double *)> measure_rows(const std::vector<Eigen::Vector3d> &points) const;
+
+	[[nodiscard]] const Eigen::Vector3d &getSphereCenter() const;
 };
 
 #endif //NEW_PLANNERS_GREATCIRCLEMETRIC_H
@@ -2,16 +2,97 @@
 #define INFORMEDMANIPULATORDRONESAMPLER_H
 
 #include <moveit/robot_state/robot_state.h>
+#include <ompl/base/ScopedState.h>
 #include <ompl/base/samplers/InformedStateSampler.h>
+#include <ompl/util/ProlateHyperspheroid.h>
+
+class DroneStateSpace;
+
+/**
+ * The informed subset {q | d(a, q) + d(q, b) <= c} of the DroneStateSpace, with d the state space distance.
+ *
+ * That distance is a sum of per-joint distances, each times the distance factor of the joint: the Euclidean distance
+ * between the base positions, plus the angle between the base orientations (half the yaw difference for an upright
+ * base) times the angular distance weight of the floating joint, plus the arm joint differences. In coordinates
+ * (x, y, z, yaw / 2, arm joints...), scaled by those factors and weights (see coordinateScales), the distance is
+ * bounded from below by the Euclidean distance. The informed subset thus lies within the prolate hyperspheroid with
+ * foci a and b and transverse diameter c in those coordinates; rejection sampling from the hyperspheroid samples
+ * the subset uniformly, and its measure bounds that of the subset.
+ *
+ * Yaw and continuous arm joints are unwrapped around their values in a, such that the foci are at most pi apart
+ * in each of them. States that are closer to b around the far side of such an angle than their unwrapped coordinate
+ * suggests fall outside the hyperspheroid, and are not sampled.
+ */
+class DroneInformedSubset {
+
+    const DroneStateSpace *space;
+
+    /// The foci, as OMPL states and in coordinates.
+    ompl::base::ScopedState<> a, b;
+    std::vector<double> focus_a, focus_b;
+
+    /// See coordinateScales.
+    std::vector<double> scales;
+
+    /// d(a, b); no state has a lower cost.
+    double focus_distance;
+
+    std::shared_ptr<ompl::ProlateHyperspheroid> phs;
+
+    /// For maxCost = infinity.
+    ompl::base::StateSamplerPtr uniform;
+
+    /// Scratch space for samples.
+    std::vector<double> coordinates;
+
+public:
+    DroneInformedSubset(const ompl::base::SpaceInformationPtr &si,
+                        const ompl::base::State *a,
+                        const ompl::base::State *b);
+
+    /**
+     * Sample uniformly from the states with minCost <= d(a, q) + d(q, b) <= maxCost.
+     *
+     * @param state     The state to write the sample to.
+     * @param minCost   Lower bound on the cost; may be 0.
+     * @param maxCost   Upper bound on the cost; may be infinite, in which case this samples the whole space.
+     * @param attempts  Number of hyperspheroid samples to try before giving up.
+     * @return          Whether a sample was found.
+     */
+    bool sample(ompl::base::State *state, double minCost, double maxCost, unsigned int attempts);
+
+    /// The measure of the hyperspheroid for the given cost, capped by the measure of the state space.
+    [[nodiscard]] double measure(double maxCost) const;
+
+    [[nodiscard]] double getFocusDistance() const {
+        return focus_distance;
+    }
+
+    /**
+     * The Euclidean counterpart of d(a, q) + d(q, b): the sum of the distances of q to the foci in coordinates.
+     * The state is in the hyperspheroid with transverse diameter c if and only if this is at most c.
+     */
+    [[nodiscard]] double coordinateCost(const ompl::base::State *state) const;
+
+    /// Number of coordinates of the drone state space: x, y, z and yaw of the base, followed by the arm joints.
+    static size_t dimension(const DroneStateSpace &space);
+
+    /**
+     * The factor by which each coordinate is scaled, such that the Euclidean distance in coordinates bounds the state
+     * space distance from below: the distance factor of the joint, times the angular distance weight over two for yaw.
+     *
+     * Measures in coordinates are those of the state space times the product of these factors.
+     */
+    static std::vector<double> coordinateScales(const DroneStateSpace &space);
+};
 
 /**
- * @todo write docs
+ * Informed sampler for the path length between two drone states; see DroneInformedSubset.
  */
 class InformedBetweenTwoDroneStatesSampler : public ompl::base::InformedSampler
 {
 
-    /// The RobotStates to sample between.
-    moveit::core::RobotState st1, st2;
+    DroneInformedSubset subset;
 
 public:
 
@@ -31,11 +112,24 @@ public:
 
 };
 
+/**
+ * Informed sampler for the path length between a drone state and the (DroneEndEffectorNearTarget) goal region.
+ *
+ * Every sample is drawn from the DroneInformedSubset between the start and a random state in the goal region,
+ * which approximates the union of those subsets over the goal region. The informed measure is that of
+ * the ball around the start with the current cost as radius (in DroneInformedSubset coordinates), which contains
+ * every state that can possibly lie on a better path.
+ */
 class InformedBetweenDroneStateAndTargetSampler : public ompl::base::InformedSampler
 {
-    moveit::core::RobotState st1;
     Eigen::Vector3d target;
 
+    /// The start, and a scratch state for goal samples.
+    ompl::base::ScopedState<> start, goal;
+
+    /// For maxCost = infinity.
+    ompl::base::StateSamplerPtr uniform;
+
 public:
 
     double getInformedMeasure(const ompl::base::Cost& currentCost) const override;
@@ -51,6 +145,10 @@ public:
 
 };
 
+/**
+ * Sample a state with a path length of at most maxDist between a and b, by dividing the remaining length randomly
+ * over the joints; not uniform (use DroneInformedSubset for that).
+ */
 bool sampleBetweenUpright(const moveit::core::RobotState& a,
     const moveit::core::RobotState& b,
     moveit::core::RobotState& result,
@@ -1,52 +1,245 @@
 #include "InformedBetweenTwoDroneStatesSampler.h"
 #include "ompl_custom.h"
 #include "DroneStateConstraintSampler.h"
+#include "DroneStateView.h"
+#include "thread_rng.h"
+#include <moveit/robot_model/floating_joint_model.h>
 #include <ompl/base/goals/GoalState.h>
+#include <ompl/util/GeometricEquations.h>
 #include <boost/range/combine.hpp>
 #include <Eigen/Geometry>
 #include <unsupported/Eigen/EulerAngles>
 
-double InformedBetweenTwoDroneStatesSampler::getInformedMeasure(const ompl::base::Cost &currentCost) const {
-    throw std::logic_error("Function not yet implemented");
+namespace {
+
+    /// Unwrap an angle, scaled by `scale`, to within pi (times the scale) of the reference.
+    double unwrapScaled(double scaled_angle, double reference, double scale) {
+        return reference + std::remainder(scaled_angle - reference, 2.0 * M_PI * scale);
+    }
+
+    /**
+     * Write the DroneInformedSubset coordinates of the state (see DroneInformedSubset::coordinateScales).
+     *
+     * If a reference is given, the yaw and continuous arm joints are unwrapped to within pi of their reference coordinates.
+     */
+    void toCoordinates(const DroneStateView &st,
+                       const std::vector<double> &scales,
+                       const std::vector<double> *reference,
+                       std::vector<double> &coordinates) {
+
+        coordinates.clear();
+
+        const Eigen::Vector3d position = st.basePosition();
+
+        coordinates.insert(coordinates.end(), {
+                scales[0] * position.x(), scales[1] * position.y(), scales[2] * position.z(), scales[3] * st.yaw()
+        });
+
+        if (reference) {
+            coordinates[3] = unwrapScaled(coordinates[3], (*reference)[3], scales[3]);
+        }
+
+        for (size_t i = 0; i < st.armJointCount(); ++i) {
+            double value = scales[4 + i] * st.armJoint(i);
+
+            if (reference && !st.armJointBounds(i).position_bounded_) {
+                value = unwrapScaled(value, (*reference)[4 + i], scales[4 + i]);
+            }
+
+            coordinates.push_back(value);
+        }
+    }
+
+    /// Inverse of toCoordinates; returns false (leaving `st` partially written) if the coordinates are out of bounds.
+    bool fromCoordinates(const double *coordinates,
+                         const std::vector<double> &scales,
+                         double translation_bound,
+                         DroneStateView &st) {
+
+        const double b = translation_bound;
+
+        const Eigen::Vector3d position(coordinates[0] / scales[0],
+                                       coordinates[1] / scales[1],
+                                       coordinates[2] / scales[2]);
+
+        if (std::abs(position.x()) > b || std::abs(position.y()) > b || position.z() < 0.0 || position.z() > b) {
+            return false;
+        }
+
+        st.setBasePosition(position);
+        st.setYaw(coordinates[3] / scales[3]);
+
+        for (size_t i = 0; i < st.armJointCount(); ++i) {
+            double value = coordinates[4 + i] / scales[4 + i];
+
+            const auto &bounds = st.armJointBounds(i);
+
+            if (bounds.position_bounded_ && (value < bounds.min_position_ || value > bounds.max_position_)) {
+                return false;
+            }
+
+            // Continuous joints are not bounded, but are normalized to [-pi, pi].
+            if (!bounds.position_bounded_) {
+                value = std::remainder(value, 2.0 * M_PI);
+            }
+
+            st.setArmJoint(i, value);
+        }
+
+        return true;
+    }
+
+    /// The product of the coordinate scales: the factor between measures in coordinates and in the state space.
+    double coordinateJacobian(const DroneStateSpace &space) {
+        double jacobian = 1.0;
+        for (double scale: DroneInformedSubset::coordinateScales(space)) {
+            jacobian *= scale;
+        }
+        return jacobian;
+    }
 }
 
-bool InformedBetweenTwoDroneStatesSampler::hasInformedMeasure() const {
+size_t DroneInformedSubset::dimension(const DroneStateSpace &space) {
+    return 4 + space.getLayout().arm.size();
+}
+
+std::vector<double> DroneInformedSubset::coordinateScales(const DroneStateSpace &space) {
+
+    // The base first, then the arm joints in the order of the DroneStateLayout.
+    std::vector<double> scales(4, 1.0);
+
+    for (const auto *jm: space.getJointModelGroup()->getActiveJointModels()) {
+        if (jm->getType() == moveit::core::JointModel::FLOATING) {
+            const double factor = jm->getDistanceFactor();
+            const double angular_weight = static_cast<const moveit::core::FloatingJointModel *>(jm)->getAngularDistanceWeight();
+            // The angle between two upright orientations is half their difference in yaw.
+            scales = {factor, factor, factor, factor * angular_weight / 2.0};
+            break;
+        }
+    }
+
+    for (const auto *jm: space.getJointModelGroup()->getActiveJointModels()) {
+        if (jm->getType() != moveit::core::JointModel::FLOATING) {
+            scales.insert(scales.end(), jm->getVariableCount(), jm->getDistanceFactor());
+        }
+    }
+
+    return scales;
+}
+
+DroneInformedSubset::DroneInformedSubset(const ompl::base::SpaceInformationPtr &si,
+                                         const ompl::base::State *a,
+                                         const ompl::base::State *b)
+        : space(si->getStateSpace()->as<DroneStateSpace>()),
+          a(si->getStateSpace(), a),
+          b(si->getStateSpace(), b),
+          scales(coordinateScales(*space)),
+          focus_distance(si->getStateSpace()->distance(a, b)),
+          uniform(si->getStateSpace()->allocDefaultStateSampler()) {
+
+    toCoordinates(DroneStateView::of(*space, a), scales, nullptr, focus_a);
+    toCoordinates(DroneStateView::of(*space, b), scales, &focus_a, focus_b);
+
+    phs = std::make_shared<ompl::ProlateHyperspheroid>(focus_a.size(), focus_a.data(), focus_b.data());
+    coordinates.resize(focus_a.size());
+}
+
+bool DroneInformedSubset::sample(ompl::base::State *state, double minCost, double maxCost, unsigned int attempts) {
+
+    // AIT* sometimes asks for costs below the minimum, and would get stuck on an exception; see
+    // https://github.com/ompl/ompl/blob/96eb89e51d84bbc75093409ce186e6826c93ec5a/src/ompl/geometric/planners/informedtrees/aitstar/src/ImplicitGraph.cpp#L339
+    if (maxCost < focus_distance) {
+        return false;
+    }
+
+    const bool bounded = std::isfinite(maxCost);
+
+    if (bounded) {
+        // The Euclidean distance between the foci is at most focus_distance; max() only guards against rounding.
+        phs->setTransverseDiameter(std::max(maxCost, phs->getMinTransverseDiameter()));
+    }
+
+    auto &rng = thread_ompl_rng();
+
+    for (unsigned int attempt = 0; attempt < attempts; ++attempt) {
+
+        if (bounded) {
+            rng.uniformProlateHyperspheroid(phs, coordinates.data());
+
+            DroneStateView view(*space, state);
+
+            if (!fromCoordinates(coordinates.data(), scales, space->getTranslationBound(), view)) {
+                continue;
+            }
+        } else {
+            uniform->sampleUniform(state);
+        }
+
+        const double cost = space->distance(a.get(), state) + space->distance(state, b.get());
+
+        if (minCost <= cost && cost <= maxCost) {
+            return true;
+        }
+    }
+
     return false;
 }
 
-bool InformedBetweenTwoDroneStatesSampler::sampleUniform(ompl::base::State *statePtr,
-                                                         const ompl::base::Cost &minCost,
-                                                         const ompl::base::Cost &maxCost) {
-    throw std::logic_error("Function not yet implemented");
+double DroneInformedSubset::measure(double maxCost) const {
+
+    if (!std::isfinite(maxCost)) {
+        return space->getMeasure();
+    }
+
+    if (maxCost < focus_distance) {
+        return 0.0;
+    }
+
+    const double phs_measure = phs->getPhsMeasure(std::max(maxCost, phs->getMinTransverseDiameter()));
+
+    return std::min(phs_measure / coordinateJacobian(*space), space->getMeasure());
 }
 
-bool InformedBetweenTwoDroneStatesSampler::sampleUniform(ompl::base::State *statePtr,
-                                                         const ompl::base::Cost &maxCost) {
+double DroneInformedSubset::coordinateCost(const ompl::base::State *state) const {
 
-    auto space = probDefn_->getSpaceInformation()->getStateSpace()->as<DroneStateSpace>();
+    std::vector<double> q;
+    toCoordinates(DroneStateView::of(*space, state), scales, &focus_a, q);
 
-    moveit::core::RobotState st(space->getRobotModel());
+    double to_a = 0.0, to_b = 0.0;
+    for (size_t i = 0; i < q.size(); ++i) {
+        to_a += std::pow(q[i] - focus_a[i], 2);
+        to_b += std::pow(q[i] - focus_b[i], 2);
+    }
 
-    bool result = sampleBetweenUpright(st1, st2, st, maxCost.value());
+    return std::sqrt(to_a) + std::sqrt(to_b);
+}
 
-    if (result) space->copyToOMPLState(statePtr, st);
-    // else, do nothing but still return false.
+double InformedBetweenTwoDroneStatesSampler::getInformedMeasure(const ompl::base::Cost &currentCost) const {
+    return subset.measure(currentCost.value());
+}
 
-    return result;
+bool InformedBetweenTwoDroneStatesSampler::hasInformedMeasure() const {
+    return true;
+}
 
+bool InformedBetweenTwoDroneStatesSampler::sampleUniform(ompl::base::State *statePtr,
+                                                         const ompl::base::Cost &minCost,
+                                                         const ompl::base::Cost &maxCost) {
+    return subset.sample(statePtr, minCost.value(), maxCost.value(), numIters_);
+}
 
+bool InformedBetweenTwoDroneStatesSampler::sampleUniform(ompl::base::State *statePtr,
+                                                         const ompl::base::Cost &maxCost) {
+    return subset.sample(statePtr, 0.0, maxCost.value(), numIters_);
 }
 
 
 InformedBetweenTwoDroneStatesSampler::InformedBetweenTwoDroneStatesSampler(
-        const ompl::base::ProblemDefinitionPtr &probDefn, unsigned int maxNumberCalls) : ompl::base::InformedSampler(
-        probDefn, maxNumberCalls),
-                                                                                         st1(probDefn->getSpaceInformation()->getStateSpace()->as<DroneStateSpace>()->getRobotModel()),
-                                                                                         st2(probDefn->getSpaceInformation()->getStateSpace()->as<DroneStateSpace>()->getRobotModel()) {
-    auto space = probDefn_->getSpaceInformation()->getStateSpace()->as<DroneStateSpace>();
-
-    space->copyToRobotState(st1, probDefn->getStartState(0));
-    space->copyToRobotState(st2, probDefn->getGoal()->as<ompl::base::GoalState>()->getState());
+        const ompl::base::ProblemDefinitionPtr &probDefn, unsigned int maxNumberCalls)
+        : ompl::base::InformedSampler(probDefn, maxNumberCalls),
+          subset(probDefn->getSpaceInformation(),
+                 probDefn->getStartState(0),
+                 probDefn->getGoal()->as<ompl::base::GoalState>()->getState()) {
 }
 
 
@@ -57,8 +250,8 @@ bool sampleBetweenUpright(const moveit::core::RobotState &a,
 
     assert(isfinite(maxDist));
 
-    // Get an RNG for sampling
-    ompl::RNG rng;
+    // Get an RNG for sampling; an ompl::RNG, since uniformProlateHyperspheroid requires one.
+    auto &rng = thread_ompl_rng();
 
     std::vector<double> weights(a.getRobotModel()->getActiveJointModels().size());
 
@@ -187,53 +380,54 @@ bool sampleBetweenUpright(const moveit::core::RobotState &a,
 }
 
 double InformedBetweenDroneStateAndTargetSampler::getInformedMeasure(const ompl::base::Cost &currentCost) const {
-    return NAN;
+
+    auto space = probDefn_->getSpaceInformation()->getStateSpace()->as<DroneStateSpace>();
+
+    if (!std::isfinite(currentCost.value())) {
+        return space->getMeasure();
+    }
+
+    // Every state on a better path is within the current cost from the start, which bounds the Euclidean distance.
+    const auto n = (unsigned int) DroneInformedSubset::dimension(*space);
+
+    const double ball_measure = ompl::unitNBallMeasure(n) * std::pow(currentCost.value(), n);
+
+    return std::min(ball_measure / coordinateJacobian(*space), space->getMeasure());
 }
 
 bool InformedBetweenDroneStateAndTargetSampler::hasInformedMeasure() const {
-    return false;
+    return true;
 }
 
 bool
 InformedBetweenDroneStateAndTargetSampler::sampleUniform(ompl::base::State *statePtr, const ompl::base::Cost &minCost,
                                                          const ompl::base::Cost &maxCost) {
 
+    if (!std::isfinite(maxCost.value())) {
+        uniform->sampleUniform(statePtr);
+        return true;
+    }
 
-    return this->sampleUniform(statePtr, maxCost); // Ignore minCost.
-}
-
-bool
-InformedBetweenDroneStateAndTargetSampler::sampleUniform(ompl::base::State *statePtr, const ompl::base::Cost &maxCost) {
-
-    moveit::core::RobotState st2(this->st1);
-
-    randomizeUprightWithBase(st2, 0.0);
-    moveEndEffectorToGoal(st2, 0.0 /* TODO check this tolerance */, this->target);
-
-    moveit::core::RobotState result(st1.getRobotModel());
-
+    DroneStateView goal_view(*probDefn_->getSpaceInformation()->getStateSpace()->as<DroneStateSpace>(), goal.get());
 
-// TODO remove the magic number here...
-    bool success = sampleBetweenUpright(st1, st2, result, isfinite(maxCost.value()) ? maxCost.value() : 100.0 * st1.distance(st2));
+    randomizeUprightWithBase(goal_view, 0.0);
+    moveEndEffectorToGoal(goal_view, 0.0 /* TODO check this tolerance */, this->target);
 
-    if (success)
-        probDefn_->getSpaceInformation()->getStateSpace()->as<DroneStateSpace>()->copyToOMPLState(statePtr, result);
+    DroneInformedSubset subset(probDefn_->getSpaceInformation(), start.get(), goal.get());
 
-    return success;
+    return subset.sample(statePtr, minCost.value(), maxCost.value(), numIters_);
+}
 
+bool
+InformedBetweenDroneStateAndTargetSampler::sampleUniform(ompl::base::State *statePtr, const ompl::base::Cost &maxCost) {
+    return this->sampleUniform(statePtr, ompl::base::Cost(0.0), maxCost);
 }
 
 InformedBetweenDroneStateAndTargetSampler::InformedBetweenDroneStateAndTargetSampler(
-        const ompl::base::ProblemDefinitionPtr &probDefn, unsigned int maxNumberCalls) : ompl::base::InformedSampler(
-        probDefn, maxNumberCalls),
-                                                                                         st1(probDefn->getSpaceInformation()->getStateSpace()->as<DroneStateSpace>()->getRobotModel()),
-                                                                                         target(probDefn->getGoal()->as<DroneEndEffectorNearTarget>()->getTarget()) {
-
-    probDefn
-            ->getSpaceInformation()
-            ->getStateSpace()
-            ->as<DroneStateSpace>()
-            ->copyToRobotState(st1, probDefn_->getStartState(0));
-
-    st1.update(true);
+        const ompl::base::ProblemDefinitionPtr &probDefn, unsigned int maxNumberCalls)
+        : ompl::base::InformedSampler(probDefn, maxNumberCalls),
+          target(probDefn->getGoal()->as<DroneEndEffectorNearTarget>()->getTarget()),
+          start(probDefn->getSpaceInformation()->getStateSpace(), probDefn->getStartState(0)),
+          goal(probDefn->getSpaceInformation()->getStateSpace()),
+          uniform(probDefn->getSpaceInformation()->getStateSpace()->allocDefaultStateSampler()) {
 }
@@ -56,14 +56,11 @@
 
 void MakeshiftExponentialSampler::sample(ompl::base::State *state) {
 
-    ompl::base::ScopedState goal_sample(this->goalRegion->getSpaceInformation());
-    goalRegion->sampleGoal(goal_sample.get());
+    goalRegion->sampleGoal(goal_sample);
 
-    ompl::base::ScopedState inBetween(this->goalRegion->getSpaceInformation());
-    space_->interpolate(start_state, goal_sample.get(), rng_.uniform01(), inBetween.get());
+    space_->interpolate(start_state, goal_sample, rng_.uniform01(), in_between);
 
-    ompl::base::ScopedState uniform_random_sample(this->goalRegion->getSpaceInformation());
-    uniformSampler->sampleUniformNear(state, inBetween.get(), std::abs(rng_.gaussian(0.0, stddev_)));
+    uniformSampler->sampleUniformNear(state, in_between, std::abs(rng_.gaussian(0.0, stddev_)));
 
 }
 
@@ -90,8 +87,16 @@ MakeshiftExponentialSampler::MakeshiftExponentialSampler(const ompl::base::State
                                                          double stddev)
         : StateSampler(space),
           uniformSampler(std::move(uniformSampler)),
-          start_state(startState),
+          start_state(space->cloneState(startState)),
           goalRegion(std::move(goalRegion)),
-          stddev_(stddev) {
+          stddev_(stddev),
+          goal_sample(space->allocState()),
+          in_between(space->allocState()) {
 //    std::cout << "New sampler" << std::endl;
 }
+
+MakeshiftExponentialSampler::~MakeshiftExponentialSampler() {
+    space_->freeState(start_state);
+    space_->freeState(goal_sample);
+    space_->freeState(in_between);
+}
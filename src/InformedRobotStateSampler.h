@@ -19,6 +19,8 @@ public:
                                 std::shared_ptr<const ompl::base::GoalSampleableRegion> goalRegion,
                                 double stddev);
 
+    ~MakeshiftExponentialSampler() override;
+
     void sample(ompl::base::State *state);
 
     void sampleUniform(ompl::base::State *state) override;
@@ -27,7 +29,9 @@ public:
 
     void sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, double stdDev) override;
 
-    const ompl::base::State *start_state;
+    /// A copy of the start state, owned by the sampler, since the sampler may outlive the query it was made for.
+    /// Copy a new start state into it rather than replacing the pointer.
+    ompl::base::State *start_state;
     std::shared_ptr<const ompl::base::GoalSampleableRegion> goalRegion;
     double stddev_;
 
@@ -35,6 +39,9 @@ private:
     const std::shared_ptr<ompl::base::StateSampler> uniformSampler;
     ompl::RNG rng_;
 
+    /// Scratch states for sample(), such that it does not allocate.
+    ompl::base::State *goal_sample, *in_between;
+
 };
 
 
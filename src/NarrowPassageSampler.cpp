@@ -0,0 +1,116 @@
+#include "NarrowPassageSampler.h"
+#include "DroneStateConstraintSampler.h"
+#include "DroneStateView.h"
+#include "ompl_custom.h"
+#include "thread_rng.h"
+
+NarrowPassageSampler::NarrowPassageSampler(const ompl::base::SpaceInformation *si,
+										   const Eigen::Vector3d &center,
+										   double radius,
+										   double stddev,
+										   double bridgeProbability,
+										   double uniformProbability,
+										   unsigned int maxAttempts)
+		: StateSampler(si->getStateSpace().get()),
+		  si(si),
+		  center(center),
+		  radius(radius),
+		  stddev(stddev),
+		  bridge_probability(bridgeProbability),
+		  uniform_probability(uniformProbability),
+		  max_attempts(maxAttempts),
+		  uniform(si->getStateSpace()->allocDefaultStateSampler()),
+		  first(si->allocState()),
+		  second(si->allocState()) {
+}
+
+NarrowPassageSampler::~NarrowPassageSampler() {
+	si->freeState(first);
+	si->freeState(second);
+}
+
+void NarrowPassageSampler::sampleInSphere(ompl::base::State *state) {
+
+	auto &rng = thread_rng();
+
+	DroneStateView view(*space_->as<DroneStateSpace>(), state);
+
+	// Randomizes yaw and arm joints; the base translation is overwritten below.
+	randomizeUprightWithBase(view, 0.0);
+
+	Eigen::Vector3d position;
+	do {
+		position = center + radius * Eigen::Vector3d(rng.uniformReal(-1.0, 1.0),
+													  rng.uniformReal(-1.0, 1.0),
+													  rng.uniformReal(-1.0, 1.0));
+	} while ((position - center).squaredNorm() > radius * radius || position.z() < 0.0);
+
+	view.setBasePosition(position);
+}
+
+void NarrowPassageSampler::perturb(ompl::base::State *state, const ompl::base::State *mean, double stdDev) {
+
+	const auto &space = *space_->as<DroneStateSpace>();
+
+	DroneStateView to(space, state);
+	gaussianNearUpright(to, DroneStateView::of(space, mean), stdDev);
+
+	// The perturbation may push the arm joints out of their limits.
+	space.enforceBounds(state);
+}
+
+void NarrowPassageSampler::sampleUniform(ompl::base::State *state) {
+
+	auto &rng = thread_rng();
+
+	if (rng.uniform01() < uniform_probability) {
+		uniform->sampleUniform(state);
+		return;
+	}
+
+	for (unsigned int attempt = 0; attempt < max_attempts; ++attempt) {
+
+		sampleInSphere(first);
+		const bool first_valid = si->isValid(first);
+
+		if (rng.uniform01() < bridge_probability) {
+			// Bridge test: both ends in collision, midpoint free.
+			if (first_valid) {
+				continue;
+			}
+
+			perturb(second, first, stddev);
+
+			if (si->isValid(second)) {
+				continue;
+			}
+
+			space_->interpolate(first, second, 0.5, state);
+
+			if (si->isValid(state)) {
+				return;
+			}
+		} else {
+			// Gaussian test: exactly one of the two is free, so the free one is near an obstacle.
+			perturb(second, first, stddev);
+
+			const bool second_valid = si->isValid(second);
+
+			if (first_valid != second_valid) {
+				space_->copyState(state, first_valid ? first : second);
+				return;
+			}
+		}
+	}
+
+	// Give up on filtering, but still stay inside the sphere.
+	sampleInSphere(state);
+}
+
+void NarrowPassageSampler::sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, double distance) {
+	uniform->sampleUniformNear(state, near, distance);
+}
+
+void NarrowPassageSampler::sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, double stdDev) {
+	perturb(state, mean, stdDev);
+}
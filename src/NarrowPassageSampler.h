@@ -0,0 +1,83 @@
+#ifndef NEW_PLANNERS_NARROWPASSAGESAMPLER_H
+#define NEW_PLANNERS_NARROWPASSAGESAMPLER_H
+
+#include <Eigen/Core>
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/base/StateSampler.h>
+
+/**
+ * A sampler for the DroneStateSpace that concentrates samples in the narrow passages between branches,
+ * rather than in the open air around the tree.
+ *
+ * Samples are drawn with the drone's base inside a sphere around the tree (typically from compute_enclosing_sphere),
+ * and then filtered with either:
+ *  - a bridge test: two colliding states a small (Gaussian) distance apart, whose midpoint is valid; or
+ *  - a Gaussian (obstacle-boundary) test: two states a small distance apart, of which exactly one is valid,
+ *    in which case the valid one is the sample.
+ *
+ * A fraction of samples is drawn uniformly from the full space, such that the planner still covers
+ * the open air that it needs to get from one side of the tree to another.
+ *
+ * The filters need validity checks, so the validity checker of the space information must be thread-safe
+ * if multiple planners sample at the same time. Since samples are filtered, not all of them are valid.
+ */
+class NarrowPassageSampler : public ompl::base::StateSampler {
+
+	const ompl::base::SpaceInformation *si;
+
+	/// The region (typically the canopy) to concentrate samples in.
+	Eigen::Vector3d center;
+	double radius;
+
+	/// Standard deviation of the distance between the two states of a bridge or Gaussian test.
+	double stddev;
+
+	/// Probability of a bridge test rather than a Gaussian test.
+	double bridge_probability;
+
+	/// Probability of sampling uniformly from the whole space instead.
+	double uniform_probability;
+
+	/// Number of tests before giving up and returning an unfiltered sample inside the sphere.
+	unsigned int max_attempts;
+
+	ompl::base::StateSamplerPtr uniform;
+
+	/// Scratch space for the states of a test.
+	ompl::base::State *first, *second;
+
+	/// A random state with the base inside the sphere (and above the ground).
+	void sampleInSphere(ompl::base::State *state);
+
+	/// Write a state near `mean` to `state`, with Gaussian noise on the translation, yaw and arm joints.
+	void perturb(ompl::base::State *state, const ompl::base::State *mean, double stdDev);
+
+public:
+	/**
+	 * @param si 					The space information, for the validity checker; the space must be a DroneStateSpace.
+	 * @param center 				Center of the sphere to concentrate samples in.
+	 * @param radius 				Radius of that sphere.
+	 * @param stddev 				Standard deviation of the distance between the states of a test.
+	 * @param bridgeProbability 	Probability of a bridge test rather than a Gaussian test.
+	 * @param uniformProbability 	Probability of sampling uniformly from the whole space instead.
+	 * @param maxAttempts 			Number of tests per sample before giving up.
+	 */
+	NarrowPassageSampler(const ompl::base::SpaceInformation *si,
+						 const Eigen::Vector3d &center,
+						 double radius,
+						 double stddev = 0.2,
+						 double bridgeProbability = 0.5,
+						 double uniformProbability = 0.1,
+						 unsigned int maxAttempts = 20);
+
+	~NarrowPassageSampler() override;
+
+	void sampleUniform(ompl::base::State *state) override;
+
+	/// Delegates to the default sampler of the space.
+	void sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, double distance) override;
+
+	void sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, double stdDev) override;
+};
+
+#endif //NEW_PLANNERS_NARROWPASSAGESAMPLER_H
@@ -0,0 +1,94 @@
+#ifndef NEW_PLANNERS_PACKEDSYMMETRICMATRIX_H
+#define NEW_PLANNERS_PACKEDSYMMETRICMATRIX_H
+
+#include <vector>
+#include <new>
+#include <utility>
+#include <cstddef>
+
+/**
+ * Allocator that aligns allocations to cache lines, such that rows of large matrices start at a line boundary
+ * and vectorized loops over them don't straddle lines unnecessarily.
+ */
+template<typename T, size_t Alignment = 64>
+struct CacheAlignedAllocator {
+
+	using value_type = T;
+
+	template<typename U>
+	struct rebind {
+		using other = CacheAlignedAllocator<U, Alignment>;
+	};
+
+	CacheAlignedAllocator() = default;
+
+	template<typename U>
+	explicit CacheAlignedAllocator(const CacheAlignedAllocator<U, Alignment> &) {
+	}
+
+	T *allocate(size_t n) {
+		return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	void deallocate(T *p, size_t) {
+		::operator delete(p, std::align_val_t(Alignment));
+	}
+
+	friend bool operator==(const CacheAlignedAllocator &, const CacheAlignedAllocator &) {
+		return true;
+	}
+
+	friend bool operator!=(const CacheAlignedAllocator &, const CacheAlignedAllocator &) {
+		return false;
+	}
+};
+
+/**
+ * A symmetric n×n matrix, of which only the upper triangle (including the diagonal) is stored,
+ * in a single flat, cache-aligned array.
+ *
+ * This takes a bit over half the memory of a full matrix, and a fraction of a vector-of-vectors.
+ * Use a 32-bit T (float, int32_t) to halve that again.
+ */
+template<typename T>
+class PackedSymmetricMatrix {
+
+	size_t n = 0;
+
+	std::vector<T, CacheAlignedAllocator<T>> entries;
+
+public:
+	PackedSymmetricMatrix() = default;
+
+	explicit PackedSymmetricMatrix(size_t n, T initial = T(0)) : n(n), entries(n * (n + 1) / 2, initial) {
+	}
+
+	[[nodiscard]] size_t size() const {
+		return n;
+	}
+
+	/// Index of the (i,j) entry in the flat array; the same for (j,i). Useful to store per-entry flags alongside.
+	[[nodiscard]] size_t index(size_t i, size_t j) const {
+		if (i > j) {
+			std::swap(i, j);
+		}
+		// Row i of the upper triangle starts after the n + (n-1) + ... + (n-i+1) entries of the rows before it.
+		return i * n - i * (i - 1) / 2 + (j - i);
+	}
+
+	/// Number of entries in the flat array.
+	[[nodiscard]] size_t packed_size() const {
+		return entries.size();
+	}
+
+	[[nodiscard]] T operator()(size_t i, size_t j) const {
+		return entries[index(i, j)];
+	}
+
+	/// Set both (i,j) and (j,i).
+	void set(size_t i, size_t j, T value) {
+		entries[index(i, j)] = value;
+	}
+};
+
+#endif //NEW_PLANNERS_PACKEDSYMMETRICMATRIX_H
@@ -5,6 +5,8 @@
 #include "InformedRobotStateSampler.h"
 #include <utility>
 #include "SamplerWrapper.h"
+#include "NarrowPassageSampler.h"
+#include "ExperienceSampler.h"
 
 SamplerWrapper::SamplerWrapper(ompl::base::StateSpace *ss) : ss_(ss) {}
 
@@ -40,7 +42,7 @@ void InformedGaussian::setStartAndGoal(const ompl::base::State *start,
                                                 stddev_));
     } else {
         underlying_sampler_->goalRegion = goal;
-        underlying_sampler_->start_state = start;
+        ss_->copyState(underlying_sampler_->start_state, start);
     }
 }
 
@@ -52,3 +54,66 @@ std::string InformedGaussian::getName() {
 
     return ss.str();
 }
+
+NarrowPassage::NarrowPassage(ompl::base::SpaceInformationPtr si, const bodies::BoundingSphere &canopy, double stddev)
+        : SamplerWrapper(si->getStateSpace().get()), si_(std::move(si)), canopy_(canopy), stddev_(stddev) {}
+
+std::shared_ptr<ompl::base::StateSampler> NarrowPassage::getSampler() {
+    return std::make_shared<NarrowPassageSampler>(si_.get(), canopy_.center, canopy_.radius, stddev_);
+}
+
+void NarrowPassage::setStartAndGoal(const ompl::base::State *start,
+                                    const std::shared_ptr<ompl::base::GoalSampleableRegion> &goal) {
+    // Narrow passages do not depend on the query.
+}
+
+std::string NarrowPassage::getName() {
+    std::stringstream ss;
+
+    ss << "NarrowPassage";
+    ss << this->stddev_;
+
+    return ss.str();
+}
+
+Experience::Experience(ompl::base::StateSpace *ss,
+                       std::shared_ptr<const ExperienceStore> store,
+                       size_t sceneHash,
+                       std::shared_ptr<SamplerWrapper> base,
+                       double bandwidth,
+                       double baseProbability)
+        : SamplerWrapper(ss),
+          store_(std::move(store)),
+          scene_hash_(sceneHash),
+          base_(std::move(base)),
+          bandwidth_(bandwidth),
+          base_probability_(baseProbability) {}
+
+std::shared_ptr<ompl::base::StateSampler> Experience::getSampler() {
+    return std::make_shared<ExperienceSampler>(ss_,
+                                               store_->states(scene_hash_),
+                                               base_ ? base_->getSampler() : std::make_shared<DroneStateSampler>(ss_),
+                                               bandwidth_,
+                                               base_probability_);
+}
+
+void Experience::setStartAndGoal(const ompl::base::State *start,
+                                 const std::shared_ptr<ompl::base::GoalSampleableRegion> &goal) {
+    // The experience itself does not depend on the query.
+    if (base_) {
+        base_->setStartAndGoal(start, goal);
+    }
+}
+
+std::string Experience::getName() {
+    std::stringstream ss;
+
+    ss << "Experience";
+    ss << this->bandwidth_;
+
+    if (base_) {
+        ss << "+" << base_->getName();
+    }
+
+    return ss.str();
+}
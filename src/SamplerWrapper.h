@@ -1,9 +1,11 @@
 #ifndef NEW_PLANNERS_SAMPLERWRAPPER_H
 #define NEW_PLANNERS_SAMPLERWRAPPER_H
 
+#include <geometric_shapes/bodies.h>
 #include <ompl/base/goals/GoalState.h>
 #include "InformedRobotStateSampler.h"
 #include "DroneStateSampler.h"
+#include "ExperienceStore.h"
 
 /**
  * \brief A wrapper around ompl::base::SpaceSampler that can accept information about the current planning problem.
@@ -60,6 +62,71 @@ public:
     std::string getName() override;
 
 };
+/**
+ * Samples the narrow passages between the branches of the tree with a NarrowPassageSampler.
+ *
+ * Independent of the start and goal, so every call to getSampler() returns a fresh sampler,
+ * which makes this wrapper safe to use with multiple planners at once.
+ */
+class NarrowPassage : public SamplerWrapper {
+
+    ompl::base::SpaceInformationPtr si_;
+    bodies::BoundingSphere canopy_;
+    double stddev_;
+
+public:
+    /**
+     * @param si        The space information, for validity checking.
+     * @param canopy    The sphere to concentrate samples in (see compute_enclosing_sphere).
+     * @param stddev    Standard deviation of the distance between the states of a bridge or Gaussian test.
+     */
+    NarrowPassage(ompl::base::SpaceInformationPtr si, const bodies::BoundingSphere &canopy, double stddev = 0.2);
+
+    std::shared_ptr<ompl::base::StateSampler> getSampler() override;
+
+    void setStartAndGoal(const ompl::base::State *start,
+                         const std::shared_ptr<ompl::base::GoalSampleableRegion> &goal) override;
+
+    std::string getName() override;
+
+};
+/**
+ * Samples near states from earlier solutions in the same scene with an ExperienceSampler, mixed with another sampler.
+ *
+ * Every call to getSampler() takes the states that are in the store at that time, such that later queries
+ * benefit from the paths that earlier ones added.
+ */
+class Experience : public SamplerWrapper {
 
+    std::shared_ptr<const ExperienceStore> store_;
+    size_t scene_hash_;
+    std::shared_ptr<SamplerWrapper> base_;
+    double bandwidth_;
+    double base_probability_;
+
+public:
+    /**
+     * @param ss                The state space.
+     * @param store             The store to take the states of past solutions from.
+     * @param sceneHash         The scene being planned in (see sceneHash()).
+     * @param base              The sampler to mix with; uniform if null. Must not depend on the start and goal.
+     * @param bandwidth         Standard deviation of the Gaussian kernel around every stored state.
+     * @param baseProbability   Probability of sampling from the base sampler rather than from the experience.
+     */
+    Experience(ompl::base::StateSpace *ss,
+               std::shared_ptr<const ExperienceStore> store,
+               size_t sceneHash,
+               std::shared_ptr<SamplerWrapper> base = nullptr,
+               double bandwidth = 0.3,
+               double baseProbability = 0.3);
+
+    std::shared_ptr<ompl::base::StateSampler> getSampler() override;
+
+    void setStartAndGoal(const ompl::base::State *start,
+                         const std::shared_ptr<ompl::base::GoalSampleableRegion> &goal) override;
+
+    std::string getName() override;
+
+};
 
 #endif //NEW_PLANNERS_SAMPLERWRAPPER_H
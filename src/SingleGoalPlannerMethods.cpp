@@ -5,39 +5,172 @@
 #include "experiment_utils.h"
 #include "probe_retreat_move.h"
 #include "DroneStateConstraintSampler.h"
+#include "DroneStateView.h"
 #include "TimedCostConvergenceTerminationCondition.h"
+#include "planners/PRMCustom.h"
+
+namespace {
+
+	/// The state sampler allocator that planners running a query on this thread should use, if any.
+	///
+	/// The StateSpace only has a single sampler allocator, shared by all threads, so rather than swapping
+	/// it in and out for every query, we install one allocator that defers to this thread-local one.
+	thread_local ompl::base::StateSamplerAllocator thread_sampler_override;
+
+	/// How many goal samples to add to the shared roadmap at a time in state_to_goal_batch.
+	const size_t GOAL_SAMPLES_PER_ROUND = 5;
+
+	/// How long to grow the shared roadmap between connectivity checks in state_to_goal_batch.
+	const double ROADMAP_GROWTH_SLICE_SECONDS = 0.02;
+
+	/// Fraction of the time per query that the corridor planner gets, before falling back to the sampling-based planner.
+	const double CORRIDOR_TIME_FRACTION = 0.5;
+
+	/// Find the shortest roadmap path from the start vertex to any of the goal vertices, if any are connected.
+	std::optional<ompl::geometric::PathGeometric> shortestRoadmapPath(PRMCustom &roadmap,
+																	  PRMCustom::Vertex start,
+																	  const std::vector<PRMCustom::Vertex> &goals) {
+		std::optional<ompl::geometric::PathGeometric> best;
+
+		for (const auto &goal: goals) {
+			if (roadmap.same_component(start, goal)) {
+				auto path = roadmap.path_distance(start, goal);
+				if (path && (!best || path->length() < best->length())) {
+					best = *path->as<ompl::geometric::PathGeometric>();
+				}
+			}
+		}
+
+		return best;
+	}
+
+	/// Sets thread_sampler_override for the lifetime of the object, and resets it on destruction,
+	/// also if the planner throws.
+	class ScopedSamplerOverride {
+	public:
+		explicit ScopedSamplerOverride(ompl::base::StateSamplerAllocator allocator) {
+			thread_sampler_override = std::move(allocator);
+		}
+
+		~ScopedSamplerOverride() {
+			thread_sampler_override = nullptr;
+		}
+	};
 
-std::optional<ompl::geometric::PathGeometric>
-SingleGoalPlannerMethods::attempt_lucky_shot(const ompl::base::State *a, const ompl::base::GoalPtr &b) {
-    moveit::core::RobotState robot_state(si->getStateSpace()->as<DroneStateSpace>()->getRobotModel());
+}
 
-    si->getStateSpace()->as<DroneStateSpace>()->copyToRobotState(robot_state, a);
+SingleGoalPlannerMethods::SingleGoalPlannerMethods(const double planTimePerAppleSeconds,
+												   ompl::base::SpaceInformationPtr si,
+												   ompl::base::OptimizationObjectivePtr optimizationObjective,
+												   ompl::base::PlannerAllocator alloc,
+												   bool useImprovisedSampler,
+												   bool tryLuckyShots,
+												   bool useCostConvergence)
+		: timePerAppleSeconds(planTimePerAppleSeconds),
+		  si(std::move(si)),
+		  optimization_objective(std::move(optimizationObjective)),
+		  alloc(std::move(alloc)),
+		  useImprovisedSampler(useImprovisedSampler), tryLuckyShots(tryLuckyShots),
+		  useCostConvergence(useCostConvergence) {
+
+	// Allocate one planner up-front to learn its name; it goes into the pool for the constructing thread.
+	auto planner = this->alloc(this->si);
+	planner_name = planner->getName();
+	planner_pool[std::this_thread::get_id()] = planner;
+
+	if (useImprovisedSampler) {
+		installSamplerDispatch();
+	}
+}
 
-    auto goal = b->as<DroneEndEffectorNearTarget>();
+void SingleGoalPlannerMethods::installSamplerDispatch() {
+	// Queries on any thread will set thread_sampler_override; anything else gets the default sampler.
+	this->si->getStateSpace()->setStateSamplerAllocator([](const ompl::base::StateSpace *ss) {
+		if (thread_sampler_override) {
+			return thread_sampler_override(ss);
+		} else {
+			return ss->allocDefaultStateSampler();
+		}
+	});
+}
 
-    moveEndEffectorToGoal(robot_state, 0.01, goal->getTarget());
+ompl::base::StateSamplerPtr SingleGoalPlannerMethods::allocBaseSampler(const ompl::base::StateSpace *ss) const {
+	return sampler ? sampler->getSampler() : ss->allocDefaultStateSampler();
+}
 
-    ompl::base::ScopedState<> state(si->getStateSpace());
+void SingleGoalPlannerMethods::setSampler(std::shared_ptr<SamplerWrapper> wrapper) {
+	sampler = std::move(wrapper);
+	installSamplerDispatch();
+}
 
-    si->getStateSpace()->as<DroneStateSpace>()->copyToOMPLState(state.get(), robot_state);
+void SingleGoalPlannerMethods::setCorridorPlanner(std::shared_ptr<EndEffectorCorridorPlanner> planner) {
+	corridor_planner = std::move(planner);
+}
 
-    if (!si->isValid(state.get())) {
-        return std::nullopt;
-    }
+ompl::base::PlannerPtr SingleGoalPlannerMethods::acquirePlanner() {
+
+	ompl::base::PlannerPtr planner;
+
+	{
+		std::lock_guard<std::mutex> lock(planner_pool_mutex);
 
-    if (si->checkMotion(a, state.get())) {
+		auto &pooled = planner_pool[std::this_thread::get_id()];
+		if (!pooled) {
+			pooled = alloc(si);
+		}
+		planner = pooled;
+	}
+
+	// Throw away the roadmap/tree of the previous query. This also drops the sampler,
+	// which might still be referring to the start state and goal of that previous query.
+	planner->clear();
+
+	return planner;
+}
 
-        ompl::geometric::PathGeometric path(si, a, state.get());
+std::optional<ompl::geometric::PathGeometric>
+SingleGoalPlannerMethods::attempt_lucky_shot(const ompl::base::State *a, const ompl::base::GoalPtr &b) {
+    auto goal = b->as<DroneEndEffectorNearTarget>();
 
-        return {path};
+    // Move a copy of the start state to the goal in place.
+    ompl::base::ScopedState<> state(si->getStateSpace(), a);
 
-    } else {
+    DroneStateView view(*si->getStateSpace()->as<DroneStateSpace>(), state.get());
+    moveEndEffectorToGoal(view, 0.01, goal->getTarget());
 
-        return {};
+    if (si->isValid(state.get()) && si->checkMotion(a, state.get())) {
+        return {ompl::geometric::PathGeometric(si, a, state.get())};
+    }
 
+    // Failing that, try a straight line to a precomputed goal state, which costs only a motion check.
+    if (goal->samplePooled(state.get()) && si->checkMotion(a, state.get())) {
+        return {ompl::geometric::PathGeometric(si, a, state.get())};
     }
+
+    return {};
 }
 
+std::optional<ompl::geometric::PathGeometric>
+SingleGoalPlannerMethods::attempt_corridor(const ompl::base::State *a,
+										   const ompl::base::GoalPtr &b,
+										   const ompl::base::PlannerTerminationCondition &ptc) {
+
+	auto goal = std::dynamic_pointer_cast<DroneEndEffectorNearTarget>(b);
+
+	if (!corridor_planner || !goal) {
+		return {};
+	}
+
+	auto result = corridor_planner->plan(
+			a, *goal, ompl::base::plannerOrTerminationCondition(
+					ptc, ompl::base::timedPlannerTerminationCondition(timePerAppleSeconds * CORRIDOR_TIME_FRACTION)));
+
+	if (result) {
+		result = optimize(*result, optimization_objective, si);
+	}
+
+	return result;
+}
 
 std::optional<ompl::geometric::PathGeometric>
 SingleGoalPlannerMethods::state_to_goal(const ompl::base::State *a, const ompl::base::GoalPtr b) {
@@ -51,22 +184,40 @@ SingleGoalPlannerMethods::state_to_goal(const ompl::base::State *a, const ompl::
         }
     }
 
-    if (useImprovisedSampler) {
-        si->getStateSpace()->setStateSamplerAllocator([&](auto ss) {
-            return std::make_shared<MakeshiftExponentialSampler>(
-                    ss,
-                    si->getStateSpace()->allocDefaultStateSampler(),
-                    a,
-                    std::dynamic_pointer_cast<ompl::base::GoalSampleableRegion>(b),
-                    0.5
-            );
-        });
-    } else {
-        // It's supposed to do this anyway after planning, but I'm paranoid, so let's clear it anyway.
-        si->getStateSpace()->clearStateSamplerAllocator();
-    }
-
-    auto ompl_planner = alloc(si);
+	double time_remaining = timePerAppleSeconds;
+
+	if (corridor_planner) {
+		auto corridor_start = ompl::time::now();
+
+		if (auto result = attempt_corridor(a, b)) {
+			return result;
+		}
+
+		// The fallback only gets what the corridor planner left of the time for this query.
+		time_remaining -= ompl::time::seconds(ompl::time::now() - corridor_start);
+	}
+
+	// The override only lives as long as this query, so it may refer to `this` and the start state; the sampler,
+	// which the pooled planner may hold on to after this function returns, copies the start state and shares the goal.
+	std::optional<ScopedSamplerOverride> sampler_override;
+	if (useImprovisedSampler) {
+		sampler_override.emplace([this, a, goal = std::dynamic_pointer_cast<ompl::base::GoalSampleableRegion>(b)](
+				const ompl::base::StateSpace *ss) {
+			return std::make_shared<MakeshiftExponentialSampler>(
+					ss,
+					allocBaseSampler(ss),
+					a,
+					goal,
+					0.5
+			);
+		});
+	} else if (sampler) {
+		sampler_override.emplace([sampler = sampler](const ompl::base::StateSpace *ss) {
+			return sampler->getSampler();
+		});
+	}
+
+    auto ompl_planner = acquirePlanner();
 
     auto start_time = std::chrono::steady_clock::now();
     ompl::base::Planner &planner = *ompl_planner;
@@ -81,9 +232,9 @@ SingleGoalPlannerMethods::state_to_goal(const ompl::base::State *a, const ompl::
     std::optional<ompl::geometric::PathGeometric> result;
 
     auto ptc = useCostConvergence ? plannerOrTerminationCondition(
-            ompl::base::timedPlannerTerminationCondition(timePerAppleSeconds),
+            ompl::base::timedPlannerTerminationCondition(time_remaining),
             TimedConversionTerminationCondition(*pdef, ompl::time::seconds(0.025), true)
-    ) : ompl::base::timedPlannerTerminationCondition(timePerAppleSeconds);
+    ) : ompl::base::timedPlannerTerminationCondition(time_remaining);
 
     if (planner.solve(ptc) ==
         ompl::base::PlannerStatus::EXACT_SOLUTION) {
@@ -93,10 +244,6 @@ SingleGoalPlannerMethods::state_to_goal(const ompl::base::State *a, const ompl::
         result = optimize(*result, optimization_objective, si);
     }
 
-    if (useImprovisedSampler) {
-        si->getStateSpace()->clearStateSamplerAllocator();
-    }
-
 	assert(!result || result->getStateCount() > 0);
 
     return result;
@@ -105,7 +252,14 @@ SingleGoalPlannerMethods::state_to_goal(const ompl::base::State *a, const ompl::
 std::optional<ompl::geometric::PathGeometric>
 SingleGoalPlannerMethods::state_to_state(const ompl::base::State *a, const ompl::base::State *b) {
 
-    auto ompl_planner = alloc(si);
+	std::optional<ScopedSamplerOverride> sampler_override;
+	if (sampler) {
+		sampler_override.emplace([sampler = sampler](const ompl::base::StateSpace *ss) {
+			return sampler->getSampler();
+		});
+	}
+
+    auto ompl_planner = acquirePlanner();
     auto result = planFromStateToState(*ompl_planner, optimization_objective, a, b, timePerAppleSeconds);
     if (result) {
         *result = optimize(*result, optimization_objective, si);
@@ -113,6 +267,91 @@ SingleGoalPlannerMethods::state_to_state(const ompl::base::State *a, const ompl:
     return result;
 }
 
+std::vector<SingleGoalPlannerMethods::GoalQueryResult>
+SingleGoalPlannerMethods::state_to_goal_batch(const std::vector<GoalQuery> &queries,
+											  const ompl::base::PlannerTerminationCondition &ptc,
+											  const std::function<void(size_t, const GoalQueryResult &)> &on_result) {
+
+	std::optional<ScopedSamplerOverride> sampler_override;
+	if (sampler) {
+		sampler_override.emplace([sampler = sampler](const ompl::base::StateSpace *ss) {
+			return sampler->getSampler();
+		});
+	}
+
+	// A single roadmap for all queries.
+	PRMCustom roadmap(si);
+
+	auto pdef = std::make_shared<ompl::base::ProblemDefinition>(si);
+	pdef->setOptimizationObjective(optimization_objective);
+	roadmap.setProblemDefinition(pdef);
+	roadmap.setup();
+
+	std::vector<GoalQueryResult> results;
+	results.reserve(queries.size());
+
+	for (const auto &query: queries) {
+
+		auto start_time = ompl::time::now();
+
+		std::optional<ompl::geometric::PathGeometric> path;
+
+		if (tryLuckyShots) {
+			path = attempt_lucky_shot(query.start, query.goal);
+		}
+
+		double time_remaining = timePerAppleSeconds;
+
+		if (!path && corridor_planner) {
+			auto corridor_start = ompl::time::now();
+
+			path = attempt_corridor(query.start, query.goal, ptc);
+
+			time_remaining -= ompl::time::seconds(ompl::time::now() - corridor_start);
+		}
+
+		if (!path) {
+			auto &goal_region = *query.goal->as<ompl::base::GoalSampleableRegion>();
+
+			// The start state becomes part of the roadmap, which helps later queries with nearby start states.
+			auto start_vertex = roadmap.insert_state(query.start);
+			auto goal_vertices = roadmap.tryConnectGoal(goal_region, GOAL_SAMPLES_PER_ROUND);
+
+			auto query_ptc = ompl::base::plannerOrTerminationCondition(
+					ptc, ompl::base::timedPlannerTerminationCondition(time_remaining));
+
+			// The roadmap may already connect the two from earlier queries, so check before growing it.
+			path = shortestRoadmapPath(roadmap, start_vertex, goal_vertices);
+
+			while (!path && !query_ptc) {
+				roadmap.growRoadmapBatch(ompl::base::plannerOrTerminationCondition(
+						query_ptc, ompl::base::timedPlannerTerminationCondition(ROADMAP_GROWTH_SLICE_SECONDS)));
+
+				auto new_goal_vertices = roadmap.tryConnectGoal(goal_region, GOAL_SAMPLES_PER_ROUND);
+				goal_vertices.insert(goal_vertices.end(), new_goal_vertices.begin(), new_goal_vertices.end());
+
+				path = shortestRoadmapPath(roadmap, start_vertex, goal_vertices);
+			}
+
+			if (path) {
+				path = optimize(*path, optimization_objective, si);
+			}
+		}
+
+		assert(!path || path->getStateCount() > 0);
+
+		results.push_back({path, ompl::time::seconds(ompl::time::now() - start_time)});
+
+		if (on_result) {
+			on_result(results.size() - 1, results.back());
+		}
+
+		checkPtc(ptc);
+	}
+
+	return results;
+}
+
 const ompl::base::OptimizationObjectivePtr &SingleGoalPlannerMethods::getOptimizationObjective() const {
     return optimization_objective;
 }
@@ -120,8 +359,10 @@ const ompl::base::OptimizationObjectivePtr &SingleGoalPlannerMethods::getOptimiz
 Json::Value SingleGoalPlannerMethods::parameters() const {
     Json::Value params;
     params["timePerAppleSeconds"] = timePerAppleSeconds;
-    params["ptp"] = alloc(si)->getName();
+    params["ptp"] = planner_name;
     params["useImprovisedSampler"] = useImprovisedSampler;
+    params["sampler"] = sampler ? sampler->getName() : "uniform";
+    params["corridor"] = corridor_planner ? corridor_planner->parameters() : Json::Value(false);
     params["tryLuckyShots"] = tryLuckyShots;
     params["useCostConvergence"] = useCostConvergence;
     return params;
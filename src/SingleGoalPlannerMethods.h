@@ -1,4 +1,3 @@
-
 #ifndef NEW_PLANNERS_SINGLEGOALPLANNERMETHODS_H
 #define NEW_PLANNERS_SINGLEGOALPLANNERMETHODS_H
 
@@ -8,7 +7,12 @@
 #include <ompl/base/Planner.h>
 #include <jsoncpp/json/value.h>
 #include <optional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include "InformedRobotStateSampler.h"
+#include "SamplerWrapper.h"
+#include "EndEffectorCorridorPlanner.h"
 
 #include <ompl/geometric/planners/prm/PRM.h>
 
@@ -26,28 +30,110 @@ class SingleGoalPlannerMethods {
     bool tryLuckyShots;
     bool useCostConvergence;
 
+	/// Replaces the default state sampler of the planners, if set; see setSampler.
+	std::shared_ptr<SamplerWrapper> sampler;
+
+	/// Tried before the sampling-based planner in point-to-goal queries, if set; see setCorridorPlanner.
+	std::shared_ptr<EndEffectorCorridorPlanner> corridor_planner;
+
+	/// Name of the planners produced by `alloc`, cached so we don't have to allocate a planner just to read it.
+	std::string planner_name;
+
+	/// Planner instances, one for every thread that has run a query through this object.
+	/// These are reused across queries (with a `clear()` in between) to avoid reconstructing
+	/// the nearest-neighbour structures and memory pools of the planner every time.
+	std::unordered_map<std::thread::id, ompl::base::PlannerPtr> planner_pool;
+
+	/// Guards planner_pool.
+	std::mutex planner_pool_mutex;
+
+	/**
+	 * Get the pooled planner instance for the calling thread, allocating it on first use.
+	 *
+	 * The planner is cleared before being returned, which also drops its state sampler
+	 * such that it will be re-allocated with the sampler allocator of the current query.
+	 */
+	ompl::base::PlannerPtr acquirePlanner();
+
+	/// Make the state space defer to the per-thread sampler overrides that queries set up.
+	void installSamplerDispatch();
+
+	/// The uniform state sampler for a query: that of `sampler` if set, or the default of the space otherwise.
+	ompl::base::StateSamplerPtr allocBaseSampler(const ompl::base::StateSpace *ss) const;
+
 public:
+	/**
+	 * A single point-to-goal query, as used by state_to_goal_batch.
+	 */
+	struct GoalQuery {
+		const ompl::base::State *start;
+		ompl::base::GoalPtr goal;
+	};
+
+	/**
+	 * The answer to a GoalQuery, along with the wall-clock time spent on that query.
+	 */
+	struct GoalQueryResult {
+		std::optional<ompl::geometric::PathGeometric> path;
+		double time_seconds;
+	};
+
     [[nodiscard]] const ompl::base::OptimizationObjectivePtr &getOptimizationObjective() const;
 
     SingleGoalPlannerMethods(const double planTimePerAppleSeconds, ompl::base::SpaceInformationPtr si,
                              ompl::base::OptimizationObjectivePtr optimizationObjective,
                              ompl::base::PlannerAllocator alloc, bool useImprovisedSampler, bool tryLuckyShots,
-                             bool useCostConvergence)
-            : timePerAppleSeconds(planTimePerAppleSeconds),
-              si(std::move(si)),
-              optimization_objective(optimizationObjective),
-              alloc(alloc),
-              useImprovisedSampler(useImprovisedSampler), tryLuckyShots(tryLuckyShots),
-              useCostConvergence(useCostConvergence) {}
+                             bool useCostConvergence);
+
+	/**
+	 * Use the given sampler (for example NarrowPassage) instead of the default state sampler in the planners;
+	 * with the improvised sampler, it replaces the uniform sampler underneath.
+	 *
+	 * Only getSampler() is used, from the threads that run queries, so the wrapper must not depend on the start
+	 * and goal of the query (setStartAndGoal is never called).
+	 */
+	void setSampler(std::shared_ptr<SamplerWrapper> wrapper);
+
+	/**
+	 * Try the given corridor planner in point-to-goal queries (after the lucky shots, if enabled), and only fall back
+	 * to the sampling-based planner if it fails. Pass null to disable.
+	 */
+	void setCorridorPlanner(std::shared_ptr<EndEffectorCorridorPlanner> planner);
 
     std::optional<ompl::geometric::PathGeometric> state_to_goal(const ompl::base::State *a, const ompl::base::GoalPtr b);
 
     std::optional<ompl::geometric::PathGeometric> state_to_state(const ompl::base::State *a, const ompl::base::State *b);
 
+	/**
+	 * Answer a batch of point-to-goal queries against a single PRM* roadmap that is shared, and grown, across
+	 * all of them; free space discovered while answering one query is reused for all subsequent ones.
+	 *
+	 * Every query gets the same time budget as a single state_to_goal call; unlike state_to_goal,
+	 * the configured planner allocator and improvised sampler are not used (the sampler of setSampler is).
+	 *
+	 * @param queries 	The queries, answered in order.
+	 * @param ptc 		Termination condition for the batch as a whole; throws PlanningTimeout when met.
+	 * @param on_result Optional; called with the index and result of every query as soon as it is answered,
+	 * 					such that results are not lost if the batch times out.
+	 * @return 			One result per query, in the same order.
+	 */
+	std::vector<GoalQueryResult> state_to_goal_batch(const std::vector<GoalQuery> &queries,
+													 const ompl::base::PlannerTerminationCondition &ptc,
+													 const std::function<void(size_t, const GoalQueryResult &)> &on_result = nullptr);
+
     [[nodiscard]] Json::Value parameters() const;
 
     std::optional<ompl::geometric::PathGeometric>
     attempt_lucky_shot(const ompl::base::State *a, const ompl::base::GoalPtr& b);
+
+	/**
+	 * Plan with the corridor planner, within a fraction of the time for a single query, or until the given
+	 * termination condition is met. Fails if no corridor planner is set, or the goal is not a DroneEndEffectorNearTarget.
+	 */
+	std::optional<ompl::geometric::PathGeometric>
+	attempt_corridor(const ompl::base::State *a,
+					 const ompl::base::GoalPtr &b,
+					 const ompl::base::PlannerTerminationCondition &ptc = ompl::base::plannerNonTerminatingCondition());
 };
 
 typedef std::function<std::shared_ptr<SingleGoalPlannerMethods>(ompl::base::SpaceInformationPtr,
@@ -1,4 +1,6 @@
 #include "SphereShell.h"
+#include "GreatCircleMetric.h"
+#include "DroneStateView.h"
 
 #include <utility>
 #include <range/v3/all.hpp>
@@ -92,6 +94,31 @@ double SphereShell::predict_path_length(const Eigen::Vector3d &a, const Eigen::V
 	return radius * acos(ra_ray.dot(rb_ray) / (radius * radius));
 }
 
+std::function<void(size_t, double *)> CollisionFreeShell::predict_path_length_rows(const std::vector<Eigen::Vector3d> &points) const {
+
+	auto shared_points = std::make_shared<std::vector<Eigen::Vector3d>>(points);
+
+	return [this, shared_points](size_t i, double *out) {
+		for (size_t j = 0; j < shared_points->size(); ++j) {
+			out[j] = predict_path_length((*shared_points)[i], (*shared_points)[j]);
+		}
+	};
+}
+
+std::function<void(size_t, double *)> SphereShell::predict_path_length_rows(const std::vector<Eigen::Vector3d> &points) const {
+
+	auto angle_rows = GreatCircleMetric(center).measure_rows(points);
+	const size_t n = points.size();
+	const double r = radius;
+
+	return [angle_rows, n, r](size_t i, double *out) {
+		angle_rows(i, out);
+		for (size_t j = 0; j < n; ++j) {
+			out[j] *= r;
+		}
+	};
+}
+
 Eigen::Vector3d SphereShell::project(const Eigen::Vector3d &a) const {
 	// Simple central projection onto the shell.
 	return center + (a - center).normalized() * radius;
@@ -137,13 +164,37 @@ double OMPLSphereShellWrapper::predict_path_length(const ompl::base::Goal *a, co
 double OMPLSphereShellWrapper::predict_path_length(const ompl::base::State *a,
 												   const ompl::base::Goal *b) const {
 
-	auto ss = si->getStateSpace()->as<DroneStateSpace>();
-	moveit::core::RobotState st(ss->getRobotModel());
-	ss->copyToRobotState(st, a);
+	const auto st = DroneStateView::of(*si->getStateSpace()->as<DroneStateSpace>(), a);
 
 	return shell->predict_path_length(
-			shell->project(st.getGlobalLinkTransform("end_effector").translation()),
+			shell->project(st.linkTransform("end_effector").translation()),
 
 						   shell->project(b->as<DroneEndEffectorNearTarget>()->getTarget()));
 }
 
+std::vector<double> OMPLSphereShellWrapper::predict_path_lengths(const ompl::base::State *a,
+																 const std::vector<const ompl::base::Goal *> &bs) const {
+
+	const auto st = DroneStateView::of(*si->getStateSpace()->as<DroneStateSpace>(), a);
+
+	Eigen::Vector3d a_on_shell = shell->project(st.linkTransform("end_effector").translation());
+
+	std::vector<double> lengths;
+	lengths.reserve(bs.size());
+	for (const auto *b: bs) {
+		lengths.push_back(shell->predict_path_length(a_on_shell, shell->project(b->as<DroneEndEffectorNearTarget>()->getTarget())));
+	}
+	return lengths;
+}
+
+std::function<void(size_t, double *)>
+OMPLSphereShellWrapper::predict_path_length_rows(const std::vector<const ompl::base::Goal *> &goals) const {
+
+	std::vector<Eigen::Vector3d> points;
+	points.reserve(goals.size());
+	for (const auto *goal: goals) {
+		points.push_back(shell->project(goal->as<DroneEndEffectorNearTarget>()->getTarget()));
+	}
+
+	return shell->predict_path_length_rows(points);
+}
@@ -65,6 +65,17 @@ public:
 			const Eigen::Vector3d &a,
 			const Eigen::Vector3d &b) const = 0;
 
+	/**
+	 * Produce a function that, given an index i, writes predict_path_length(points[i], points[j]) for every j
+	 * into an output array. The function is thread-safe.
+	 *
+	 * The default calls predict_path_length for every pair; implementations can override this with a batched kernel.
+	 *
+	 * @param points 	The points (assumed to be on the shell); copied, so they need not outlive the function.
+	 */
+	[[nodiscard]] virtual std::function<void(size_t, double *)> predict_path_length_rows(
+			const std::vector<Eigen::Vector3d> &points) const;
+
 };
 
 /**
@@ -124,6 +135,12 @@ public:
 	 * @return 			The predicted length.
 	 */
 	[[nodiscard]] double predict_path_length(const Eigen::Vector3d &a, const Eigen::Vector3d &b) const override;
+
+	/**
+	 * Batched version of predict_path_length: the points are normalized once, after which every row
+	 * is a vectorized dot-product and acos over all points (see great_circle_angles).
+	 */
+	[[nodiscard]] std::function<void(size_t, double *)> predict_path_length_rows(const std::vector<Eigen::Vector3d> &points) const override;
 };
 
 /**
@@ -157,6 +174,18 @@ public:
 
 	[[nodiscard]] double predict_path_length(const ompl::base::State* a, const ompl::base::Goal* b) const;
 
+	/**
+	 * Predict the path length from a state to every goal; unlike calling predict_path_length for every goal,
+	 * this computes the forward kinematics of the state only once.
+	 */
+	[[nodiscard]] std::vector<double> predict_path_lengths(const ompl::base::State* a, const std::vector<const ompl::base::Goal*>& bs) const;
+
+	/**
+	 * Rows of predicted path lengths between the goals, with the goal targets projected onto the shell only once;
+	 * see CollisionFreeShell::predict_path_length_rows.
+	 */
+	[[nodiscard]] std::function<void(size_t, double *)> predict_path_length_rows(const std::vector<const ompl::base::Goal*>& goals) const;
+
 
 };
 
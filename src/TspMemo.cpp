@@ -0,0 +1,113 @@
+#include "TspMemo.h"
+
+#include <algorithm>
+#include <sstream>
+#include <boost/functional/hash.hpp>
+
+namespace {
+	/**
+	 * Translate a sequence of item hashes into indices into item_hashes, skipping unknown items.
+	 */
+	std::vector<size_t> toIndices(const std::vector<size_t> &hash_ordering, const std::vector<size_t> &item_hashes) {
+
+		std::unordered_map<size_t, size_t> index_of;
+		for (size_t i = 0; i < item_hashes.size(); ++i) {
+			index_of[item_hashes[i]] = i;
+		}
+
+		std::vector<size_t> ordering;
+		for (size_t hash: hash_ordering) {
+			auto fnd = index_of.find(hash);
+			if (fnd != index_of.end()) {
+				ordering.push_back(fnd->second);
+			}
+		}
+		return ordering;
+	}
+}
+
+std::string TspMemo::Key::toString() const {
+	std::stringstream ss;
+	ss << goal_set_hash << "/" << heuristic << "/" << options;
+	return ss.str();
+}
+
+size_t TspMemo::hashPosition(const Eigen::Vector3d &position) {
+	size_t seed = 0;
+	boost::hash_combine(seed, position.x());
+	boost::hash_combine(seed, position.y());
+	boost::hash_combine(seed, position.z());
+	return seed;
+}
+
+size_t TspMemo::hashGoalSet(const Eigen::Vector3d &start, const std::vector<size_t> &item_hashes) {
+
+	// The set is unordered, so sort the hashes to make the result independent of the order of the items.
+	std::vector<size_t> sorted = item_hashes;
+	std::sort(sorted.begin(), sorted.end());
+
+	size_t seed = hashPosition(start);
+	boost::hash_range(seed, sorted.begin(), sorted.end());
+	return seed;
+}
+
+std::optional<std::vector<size_t>> TspMemo::lookup(const TspMemo::Key &key, const std::vector<size_t> &item_hashes) const {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto fnd = orderings.find(key.toString());
+
+	if (fnd != orderings.end()) {
+		auto ordering = toIndices(fnd->second, item_hashes);
+
+		// Guard against hash collisions: the ordering must visit exactly these items.
+		if (ordering.size() == item_hashes.size()) {
+			hits += 1;
+			return {ordering};
+		}
+	}
+
+	misses += 1;
+	return {};
+}
+
+std::vector<size_t> TspMemo::warmStart(const std::string &heuristic, const std::vector<size_t> &item_hashes) const {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto fnd = latest.find(heuristic);
+
+	if (fnd == latest.end()) {
+		return {};
+	}
+
+	return toIndices(fnd->second, item_hashes);
+}
+
+void TspMemo::store(const TspMemo::Key &key,
+					const std::vector<size_t> &item_hashes,
+					const std::vector<size_t> &ordering,
+					bool completed) {
+
+	std::vector<size_t> hash_ordering;
+	hash_ordering.reserve(ordering.size());
+	for (size_t i: ordering) {
+		hash_ordering.push_back(item_hashes[i]);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (completed) {
+		orderings[key.toString()] = hash_ordering;
+	}
+	latest[key.heuristic] = std::move(hash_ordering);
+}
+
+Json::Value TspMemo::statistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Json::Value stats;
+	stats["entries"] = (Json::UInt64) orderings.size();
+	stats["hits"] = (Json::UInt64) hits;
+	stats["misses"] = (Json::UInt64) misses;
+	return stats;
+}
@@ -0,0 +1,91 @@
+#ifndef NEW_PLANNERS_TSPMEMO_H
+#define NEW_PLANNERS_TSPMEMO_H
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+#include <jsoncpp/json/value.h>
+
+/**
+ * A thread-safe memo of visiting orders, such that an ordering problem that comes up repeatedly
+ * (the same apples in the same scene, from the same start) is only solved once, and such that an ordering
+ * problem that differs only slightly from a previous one (a few apples added or removed) can be warm-started.
+ *
+ * Items are identified by a hash of their position (see hashPosition), not by their index,
+ * since indices shift when items are added or removed.
+ */
+class TspMemo {
+
+public:
+	/**
+	 * Identifies an ordering problem.
+	 */
+	struct Key {
+		/// See hashGoalSet()
+		size_t goal_set_hash;
+		/// Name of the distance heuristic that the ordering was computed with.
+		std::string heuristic;
+		/// The solver options that the ordering was computed with (see TspOptions::memoKey).
+		std::string options;
+
+		[[nodiscard]] std::string toString() const;
+	};
+
+private:
+	/// Orderings, as sequences of item hashes, by Key::toString().
+	std::unordered_map<std::string, std::vector<size_t>> orderings;
+
+	/// The most recently stored ordering for every heuristic, used for warm starts.
+	std::unordered_map<std::string, std::vector<size_t>> latest;
+
+	/// Guards `orderings` and `latest`
+	mutable std::mutex mutex;
+
+	/// Number of lookups that hit/missed, for statistics.
+	mutable size_t hits = 0, misses = 0;
+
+public:
+	/**
+	 * Hash a position exactly (no rounding); items are expected to come from the same scene, not to be re-computed.
+	 */
+	static size_t hashPosition(const Eigen::Vector3d &position);
+
+	/**
+	 * Hash the start and the (unordered) set of item positions.
+	 */
+	static size_t hashGoalSet(const Eigen::Vector3d &start, const std::vector<size_t> &item_hashes);
+
+	/**
+	 * Look up the ordering of exactly these items, as indices into item_hashes.
+	 */
+	std::optional<std::vector<size_t>> lookup(const Key &key, const std::vector<size_t> &item_hashes) const;
+
+	/**
+	 * Translate the most recent ordering computed with the same heuristic (with any options) to indices into item_hashes,
+	 * skipping items that are not in item_hashes, for use as a warm start (see repair_tour).
+	 *
+	 * @return The translated ordering; empty if there is nothing to start from.
+	 */
+	[[nodiscard]] std::vector<size_t> warmStart(const std::string &heuristic, const std::vector<size_t> &item_hashes) const;
+
+	/**
+	 * Store an ordering (as indices into item_hashes), replacing any ordering stored under the same key.
+	 *
+	 * @param completed Whether the solve ran to completion; if it was cut short (by a ptc), the ordering
+	 * 					is only kept as a warm start, and later lookups of the key still miss.
+	 */
+	void store(const Key &key,
+			   const std::vector<size_t> &item_hashes,
+			   const std::vector<size_t> &ordering,
+			   bool completed = true);
+
+	/**
+	 * Lookup hit/miss counts.
+	 */
+	[[nodiscard]] Json::Value statistics() const;
+
+};
+
+#endif //NEW_PLANNERS_TSPMEMO_H
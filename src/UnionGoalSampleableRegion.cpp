@@ -1,22 +1,33 @@
 
 #include "UnionGoalSampleableRegion.h"
+#include "ompl_custom.h"
 
+#include <execution>
+#include <numeric>
 #include <utility>
 
+/// Below this many sub-goals, queries are answered sequentially; the threading overhead would not pay off.
+static const size_t PARALLEL_QUERY_THRESHOLD = 32;
+
 double UnionGoalSampleableRegion::distanceGoal(const ompl::base::State *st) const {
-    double distance = INFINITY;
 
-    for (const auto &goal: goals) {
-        distance = std::min(distance, goal->distanceGoal(st));
-    }
+    auto distance = [&](const auto &goal) {
+        return goal->distanceGoal(st);
+    };
+
+    auto min = [](double a, double b) {
+        return std::min(a, b);
+    };
 
-    return distance;
+    if (goals.size() >= PARALLEL_QUERY_THRESHOLD) {
+        return std::transform_reduce(std::execution::par, goals.begin(), goals.end(), (double) INFINITY, min, distance);
+    } else {
+        return std::transform_reduce(goals.begin(), goals.end(), (double) INFINITY, min, distance);
+    }
 }
 
 void UnionGoalSampleableRegion::sampleGoal(ompl::base::State *st) const {
 
-    ompl::RNG rng;
-
     for (size_t i = 0; i < goals.size(); i++) {
 
         const std::shared_ptr<const GoalSampleableRegion> &goalToTry = goals[next_goal];
@@ -52,9 +63,126 @@ UnionGoalSampleableRegion::UnionGoalSampleableRegion(const ompl::base::SpaceInfo
                                                      std::vector<std::shared_ptr<const GoalSampleableRegion>> goals)
         : GoalSampleableRegion(si), goals(std::move(goals)) {}
 
-std::optional<size_t> UnionGoalSampleableRegion::whichSatisfied(ompl::base::State *st) {
-    auto fnd = std::find_if(goals.begin(), goals.end(),
-                            [&](const auto &sub_goal) { return sub_goal->isSatisfied(st); });
+std::optional<size_t> UnionGoalSampleableRegion::whichSatisfied(const ompl::base::State *st) const {
+
+    auto satisfies = [&](const auto &sub_goal) { return sub_goal->isSatisfied(st); };
+
+    // The parallel find_if still returns the first match.
+    auto fnd = goals.size() >= PARALLEL_QUERY_THRESHOLD
+               ? std::find_if(std::execution::par, goals.begin(), goals.end(), satisfies)
+               : std::find_if(goals.begin(), goals.end(), satisfies);
+
     if (fnd == goals.end()) return {};
     else return {fnd - goals.begin()};
 }
+
+AdaptiveUnionGoalSampleableRegion::AdaptiveUnionGoalSampleableRegion(
+        const ompl::base::SpaceInformationPtr &si,
+        std::vector<std::shared_ptr<const GoalSampleableRegion>> goals,
+        double exploration)
+        : UnionGoalSampleableRegion(si, std::move(goals)), exploration(exploration) {
+    statistics.resize(this->goals.size());
+
+    for (const auto &goal: this->goals) {
+        counting_goals.push_back(dynamic_cast<const DroneEndEffectorNearTarget *>(goal.get()));
+    }
+}
+
+double AdaptiveUnionGoalSampleableRegion::yield(size_t goal_i) const {
+
+    if (const auto *counting = counting_goals[goal_i]) {
+        const size_t tried = counting->getSamplesTried();
+        // Samples taken from a GoalStatePool are not counted; those are all valid.
+        return tried == 0 ? 1.0 : (double) counting->getSamplesYielded() / (double) tried;
+    }
+
+    const auto &stats = statistics[goal_i];
+    return stats.samples == 0 ? 0.0 : (double) stats.valid / (double) stats.samples;
+}
+
+std::optional<size_t> AdaptiveUnionGoalSampleableRegion::selectGoal() const {
+
+    std::optional<size_t> best;
+    double best_score = -INFINITY;
+
+    for (size_t i = 0; i < goals.size(); ++i) {
+
+        if (!goals[i]->canSample()) {
+            continue;
+        }
+
+        const auto &stats = statistics[i];
+
+        if (stats.samples == 0) {
+            return i;
+        }
+
+        // Laplace-smoothed, such that a sub-goal is not written off before any connections are reported.
+        const double connection_rate = (double) (stats.connections + 1) / (double) (stats.connection_attempts + 2);
+        const double productivity = yield(i) * connection_rate;
+
+        const double score = productivity +
+                             exploration * std::sqrt(std::log((double) total_samples) / (double) stats.samples);
+
+        if (score > best_score) {
+            best_score = score;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+void AdaptiveUnionGoalSampleableRegion::sampleGoal(ompl::base::State *st) const {
+
+    std::optional<size_t> goal_i;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        goal_i = selectGoal();
+    }
+
+    if (!goal_i) {
+        OMPL_ERROR("AdaptiveUnionGoalSampleableRegion : No goals can sample.");
+        return;
+    }
+
+    goals[*goal_i]->sampleGoal(st);
+
+    // Sub-goals that count their own valid samples need no extra check.
+    const bool valid = !counting_goals[*goal_i] && si_->isValid(st);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    statistics[*goal_i].samples += 1;
+    statistics[*goal_i].valid += valid;
+    total_samples += 1;
+}
+
+void AdaptiveUnionGoalSampleableRegion::reportConnection(const ompl::base::State *st, bool success) {
+
+    auto goal_i = whichSatisfied(st);
+
+    if (!goal_i) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    statistics[*goal_i].connection_attempts += 1;
+    statistics[*goal_i].connections += success;
+}
+
+Json::Value AdaptiveUnionGoalSampleableRegion::getStatistics() const {
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Json::Value json;
+    for (size_t i = 0; i < statistics.size(); ++i) {
+        const auto &stats = statistics[i];
+        Json::Value goal_json;
+        goal_json["samples"] = (Json::UInt64) stats.samples;
+        goal_json["yield"] = yield(i);
+        goal_json["connection_rate"] = stats.connection_attempts == 0 ? 0.0 :
+                                       (double) stats.connections / (double) stats.connection_attempts;
+        json.append(goal_json);
+    }
+    return json;
+}
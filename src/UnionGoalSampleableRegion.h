@@ -5,17 +5,25 @@
 #ifndef NEW_PLANNERS_UNIONGOALSAMPLEABLEREGION_H
 #define NEW_PLANNERS_UNIONGOALSAMPLEABLEREGION_H
 
+#include <mutex>
 #include <optional>
+#include <jsoncpp/json/value.h>
 #include <ompl/base/goals/GoalSampleableRegion.h>
 
 /**
  * Represents the union of all goal sampling regions.
  * Samples are drawn sequentially from each sub-region.
+ *
+ * Distance and satisfaction queries check the sub-goals in parallel once there are many of them,
+ * so the sub-goals must be safe to query concurrently.
  */
 class UnionGoalSampleableRegion : public ompl::base::GoalSampleableRegion {
 
+protected:
     std::vector<std::shared_ptr<const GoalSampleableRegion>> goals;
 
+private:
+
     // sampleGoal really shouldn't be const... Oh well.
     mutable size_t next_goal = 0;
 
@@ -34,8 +42,68 @@ public:
      * @param st The state to check against.
      * @return Index of the first match, or none if no matches are found.
      */
-    std::optional<size_t> whichSatisfied(ompl::base::State *st);
+    std::optional<size_t> whichSatisfied(const ompl::base::State *st) const;
+
+};
+
+/**
+ * A UnionGoalSampleableRegion that draws samples from the sub-goals that are most productive, rather than round-robin.
+ *
+ * Per sub-goal, it tracks the yield (the fraction of samples that are valid) and the connection success rate
+ * (as reported by the planner through reportConnection), and picks the sub-goal to sample from with UCB1:
+ * the estimated productivity (yield times connection rate) plus an exploration bonus that shrinks as a sub-goal
+ * is sampled more often. Every sub-goal is sampled once before the estimates are used.
+ *
+ * The yield of DroneEndEffectorNearTarget sub-goals is read from their own sample counters, since they
+ * check validity themselves; for other sub-goals, every sample costs an extra validity check to measure it.
+ */
+class DroneEndEffectorNearTarget;
+
+class AdaptiveUnionGoalSampleableRegion : public UnionGoalSampleableRegion {
+
+    struct SubGoalStatistics {
+        size_t samples = 0;
+        size_t valid = 0;
+        size_t connection_attempts = 0;
+        size_t connections = 0;
+    };
+
+    /// Weight of the exploration bonus; sqrt(2) is the classic choice for rewards in [0, 1].
+    double exploration;
+
+    mutable std::vector<SubGoalStatistics> statistics;
+
+    /// Per sub-goal, the sub-goal itself if it counts its own valid samples, or null.
+    std::vector<const DroneEndEffectorNearTarget *> counting_goals;
+    mutable size_t total_samples = 0;
+
+    /// Guards the statistics; sampling itself happens outside the lock.
+    mutable std::mutex mutex;
+
+    /// The sub-goal with the best UCB1 score (or the first one not sampled yet) that can sample.
+    std::optional<size_t> selectGoal() const;
+
+    /// The fraction of valid samples of the given sub-goal.
+    [[nodiscard]] double yield(size_t goal_i) const;
+
+public:
+    AdaptiveUnionGoalSampleableRegion(const ompl::base::SpaceInformationPtr &si,
+                                      std::vector<std::shared_ptr<const GoalSampleableRegion>> goals,
+                                      double exploration = M_SQRT2);
+
+    void sampleGoal(ompl::base::State *st) const override;
+
+    /**
+     * Report whether the planner managed to connect a goal sample to its roadmap or tree,
+     * such that sub-goals whose samples tend to be unreachable are sampled less.
+     *
+     * @param st 		The goal sample; attributed to the first sub-goal it satisfies.
+     * @param success 	Whether the connection succeeded.
+     */
+    void reportConnection(const ompl::base::State *st, bool success);
 
+    /// Per sub-goal: the sample count, yield and connection rate.
+    [[nodiscard]] Json::Value getStatistics() const;
 };
 
 #endif //NEW_PLANNERS_UNIONGOALSAMPLEABLEREGION_H
@@ -0,0 +1,110 @@
+#include "VoxelOccupancy.h"
+
+#include <algorithm>
+#include <geometric_shapes/body_operations.h>
+#include <geometric_shapes/shape_operations.h>
+#include <Eigen/Geometry>
+
+namespace {
+	Eigen::Isometry3d poseFromMsg(const geometry_msgs::msg::Pose &pose) {
+		Eigen::Isometry3d result = Eigen::Isometry3d::Identity();
+		result.translation() = Eigen::Vector3d(pose.position.x, pose.position.y, pose.position.z);
+		result.linear() = Eigen::Quaterniond(pose.orientation.w,
+											 pose.orientation.x,
+											 pose.orientation.y,
+											 pose.orientation.z).normalized().toRotationMatrix();
+		return result;
+	}
+
+	void addShape(VoxelOccupancy &occupancy,
+				  const shapes::ShapeConstPtr &shape,
+				  const Eigen::Isometry3d &pose,
+				  double clearance) {
+		if (!shape) {
+			return;
+		}
+
+		std::unique_ptr<bodies::Body> body(bodies::createBodyFromShape(shape.get()));
+		if (!body) {
+			return;
+		}
+
+		body->setPaddingDirty(clearance);
+		body->setPose(pose);
+
+		occupancy.addBody(*body);
+	}
+}
+
+VoxelOccupancy::VoxelOccupancy(double resolution) : resolution(resolution) {
+}
+
+VoxelOccupancy VoxelOccupancy::fromSceneMessage(const moveit_msgs::msg::PlanningScene &message,
+												double resolution,
+												double clearance,
+												const std::vector<std::string> &ignored_ids) {
+
+	VoxelOccupancy occupancy(resolution);
+
+	for (const auto &object: message.world.collision_objects) {
+
+		if (std::find(ignored_ids.begin(), ignored_ids.end(), object.id) != ignored_ids.end()) {
+			continue;
+		}
+
+		for (size_t i = 0; i < object.primitives.size(); ++i) {
+			addShape(occupancy,
+					 shapes::ShapeConstPtr(shapes::constructShapeFromMsg(object.primitives[i])),
+					 i < object.primitive_poses.size() ? poseFromMsg(object.primitive_poses[i])
+													   : Eigen::Isometry3d::Identity(),
+					 clearance);
+		}
+
+		for (size_t i = 0; i < object.meshes.size(); ++i) {
+			addShape(occupancy,
+					 shapes::ShapeConstPtr(shapes::constructShapeFromMsg(object.meshes[i])),
+					 i < object.mesh_poses.size() ? poseFromMsg(object.mesh_poses[i])
+												  : Eigen::Isometry3d::Identity(),
+					 clearance);
+		}
+	}
+
+	return occupancy;
+}
+
+void VoxelOccupancy::addBody(const bodies::Body &body) {
+
+	bodies::BoundingSphere sphere;
+	body.computeBoundingSphere(sphere);
+
+	Voxel lower = voxelAt(sphere.center - Eigen::Vector3d::Constant(sphere.radius));
+	Voxel upper = voxelAt(sphere.center + Eigen::Vector3d::Constant(sphere.radius));
+
+	for (int x = lower.x(); x <= upper.x(); ++x) {
+		for (int y = lower.y(); y <= upper.y(); ++y) {
+			for (int z = lower.z(); z <= upper.z(); ++z) {
+				Voxel voxel(x, y, z);
+				if (body.containsPoint(voxelCenter(voxel))) {
+					occupied.insert(pack(voxel));
+				}
+			}
+		}
+	}
+}
+
+VoxelOccupancy::Voxel VoxelOccupancy::voxelAt(const Eigen::Vector3d &point) const {
+	return (point / resolution).array().floor().cast<int>().matrix();
+}
+
+Eigen::Vector3d VoxelOccupancy::voxelCenter(const Voxel &voxel) const {
+	return ((voxel.cast<double>().array() + 0.5) * resolution).matrix();
+}
+
+uint64_t VoxelOccupancy::pack(const Voxel &voxel) {
+	const int64_t offset = 1 << 20;
+	const uint64_t mask = (1 << 21) - 1;
+
+	return (((uint64_t) (voxel.x() + offset) & mask) << 42) |
+		   (((uint64_t) (voxel.y() + offset) & mask) << 21) |
+		   ((uint64_t) (voxel.z() + offset) & mask);
+}
@@ -0,0 +1,78 @@
+#ifndef NEW_PLANNERS_VOXELOCCUPANCY_H
+#define NEW_PLANNERS_VOXELOCCUPANCY_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <Eigen/Core>
+#include <geometric_shapes/bodies.h>
+#include <moveit_msgs/msg/planning_scene.hpp>
+
+/**
+ * A sparse voxel occupancy map of the obstacles in a scene, inflated by a clearance, for searches that are
+ * cheaper than full collision checks (see EndEffectorCorridorPlanner).
+ *
+ * Only occupied voxels are stored, so the map is unbounded: everything outside the obstacles is free.
+ */
+class VoxelOccupancy {
+
+public:
+	typedef Eigen::Vector3i Voxel;
+
+private:
+	/// Edge length of a voxel.
+	double resolution;
+
+	/// The occupied voxels (see pack()).
+	std::unordered_set<uint64_t> occupied;
+
+public:
+	explicit VoxelOccupancy(double resolution);
+
+	/**
+	 * Build the occupancy of the collision objects in a planning scene message (primitives and meshes).
+	 *
+	 * Meshes are treated as convex, which holds for the convex decomposition of the trunk that
+	 * createMeshBasedAppleTreePlanningSceneMessage produces.
+	 *
+	 * @param message 		The planning scene message.
+	 * @param resolution 	Edge length of a voxel.
+	 * @param clearance 	Distance by which the obstacles are inflated.
+	 * @param ignored_ids 	Collision objects to leave out: by default those the robot is allowed to touch, and the floor
+	 * 						(searches are expected to stay above the ground themselves).
+	 */
+	static VoxelOccupancy fromSceneMessage(const moveit_msgs::msg::PlanningScene &message,
+										   double resolution,
+										   double clearance,
+										   const std::vector<std::string> &ignored_ids = {"leaves", "apples", "floor"});
+
+	/// Mark every voxel whose center lies inside the body (including its padding).
+	void addBody(const bodies::Body &body);
+
+	[[nodiscard]] Voxel voxelAt(const Eigen::Vector3d &point) const;
+
+	[[nodiscard]] Eigen::Vector3d voxelCenter(const Voxel &voxel) const;
+
+	[[nodiscard]] bool isOccupied(const Voxel &voxel) const {
+		return occupied.count(pack(voxel)) > 0;
+	}
+
+	[[nodiscard]] bool isOccupied(const Eigen::Vector3d &point) const {
+		return isOccupied(voxelAt(point));
+	}
+
+	[[nodiscard]] double getResolution() const {
+		return resolution;
+	}
+
+	/// Number of occupied voxels.
+	[[nodiscard]] size_t size() const {
+		return occupied.size();
+	}
+
+	/// A unique key for a voxel, for voxels within 2^20 voxels of the origin on every axis.
+	static uint64_t pack(const Voxel &voxel);
+};
+
+#endif //NEW_PLANNERS_VOXELOCCUPANCY_H
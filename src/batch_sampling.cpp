@@ -0,0 +1,34 @@
+#include <execution>
+#include "batch_sampling.h"
+#include "general_utilities.h"
+
+void sample_uniform_batch(ompl::base::StateSampler &sampler, const std::vector<ompl::base::State *> &states) {
+	if (auto batch_sampler = dynamic_cast<BatchStateSampler *>(&sampler)) {
+		batch_sampler->sampleUniformBatch(states);
+	} else {
+		for (auto state: states) {
+			sampler.sampleUniform(state);
+		}
+	}
+}
+
+std::vector<char> check_validity_batch(const ompl::base::SpaceInformation &si,
+									   const std::vector<ompl::base::State *> &states,
+									   bool parallel) {
+
+	std::vector<char> valid(states.size());
+
+	auto check = [&](size_t i) {
+		valid[i] = si.isValid(states[i]);
+	};
+
+	auto indices = index_vector(states);
+
+	if (parallel) {
+		std::for_each(std::execution::par, indices.begin(), indices.end(), check);
+	} else {
+		std::for_each(indices.begin(), indices.end(), check);
+	}
+
+	return valid;
+}
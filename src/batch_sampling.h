@@ -0,0 +1,44 @@
+#ifndef NEW_PLANNERS_BATCH_SAMPLING_H
+#define NEW_PLANNERS_BATCH_SAMPLING_H
+
+#include <vector>
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/base/StateSampler.h>
+
+/**
+ * A state sampler that can fill many states per call, amortizing the per-sample overhead (virtual calls,
+ * scratch RobotStates, random number generation) over the batch.
+ *
+ * OMPL samplers implement this alongside ompl::base::StateSampler; use sample_uniform_batch to use it
+ * where available, without having to know the type of the sampler.
+ */
+class BatchStateSampler {
+public:
+	virtual ~BatchStateSampler() = default;
+
+	/**
+	 * Sample every state uniformly; equivalent to calling sampleUniform on each.
+	 *
+	 * @param states The (allocated) states to write to.
+	 */
+	virtual void sampleUniformBatch(const std::vector<ompl::base::State *> &states) = 0;
+};
+
+/**
+ * Sample the states uniformly; in a single batch if the sampler implements BatchStateSampler, one at a time otherwise.
+ */
+void sample_uniform_batch(ompl::base::StateSampler &sampler, const std::vector<ompl::base::State *> &states);
+
+/**
+ * Check the validity of a batch of states.
+ *
+ * @param si 		The space information, with the validity checker to use.
+ * @param states 	The states to check.
+ * @param parallel 	Whether to check the states in parallel; only if the validity checker is thread-safe.
+ * @return 			Per state, whether it is valid (as char rather than bool, such that threads can write concurrently).
+ */
+std::vector<char> check_validity_batch(const ompl::base::SpaceInformation &si,
+									   const std::vector<ompl::base::State *> &states,
+									   bool parallel = false);
+
+#endif //NEW_PLANNERS_BATCH_SAMPLING_H
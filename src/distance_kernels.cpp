@@ -0,0 +1,71 @@
+
+#include "distance_kernels.h"
+
+#include <cmath>
+#include <algorithm>
+
+PointsSoA PointsSoA::from(const std::vector<Eigen::Vector3d> &points) {
+
+	PointsSoA soa;
+	soa.x.reserve(points.size());
+	soa.y.reserve(points.size());
+	soa.z.reserve(points.size());
+
+	for (const auto &p: points) {
+		soa.x.push_back(p.x());
+		soa.y.push_back(p.y());
+		soa.z.push_back(p.z());
+	}
+
+	return soa;
+}
+
+PointsSoA PointsSoA::directions_from(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center) {
+
+	PointsSoA soa;
+	soa.x.reserve(points.size());
+	soa.y.reserve(points.size());
+	soa.z.reserve(points.size());
+
+	for (const auto &p: points) {
+		Eigen::Vector3d direction = (p - center).normalized();
+		soa.x.push_back(direction.x());
+		soa.y.push_back(direction.y());
+		soa.z.push_back(direction.z());
+	}
+
+	return soa;
+}
+
+void euclidean_distances(const Eigen::Vector3d &from, const PointsSoA &points, double *out) {
+
+	const double fx = from.x(), fy = from.y(), fz = from.z();
+	const double *__restrict px = points.x.data();
+	const double *__restrict py = points.y.data();
+	const double *__restrict pz = points.z.data();
+	const size_t n = points.size();
+
+	for (size_t i = 0; i < n; ++i) {
+		const double dx = px[i] - fx, dy = py[i] - fy, dz = pz[i] - fz;
+		out[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+}
+
+void great_circle_angles(const Eigen::Vector3d &from_direction, const PointsSoA &directions, double *out) {
+
+	const double fx = from_direction.x(), fy = from_direction.y(), fz = from_direction.z();
+	const double *__restrict px = directions.x.data();
+	const double *__restrict py = directions.y.data();
+	const double *__restrict pz = directions.z.data();
+	const size_t n = directions.size();
+
+	// Dot products first, in a loop of its own that vectorizes regardless of whether acos does.
+	for (size_t i = 0; i < n; ++i) {
+		// Clamp to guard against rounding errors pushing the dot product of (nearly) equal directions above 1.
+		out[i] = std::clamp(px[i] * fx + py[i] * fy + pz[i] * fz, -1.0, 1.0);
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		out[i] = std::acos(out[i]);
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef NEW_PLANNERS_DISTANCE_KERNELS_H
+#define NEW_PLANNERS_DISTANCE_KERNELS_H
+
+#include <vector>
+#include <Eigen/Core>
+
+/**
+ * A set of points in structure-of-arrays layout, such that loops computing distances
+ * from one point to all of them are straightforward for the compiler to vectorize.
+ */
+struct PointsSoA {
+	std::vector<double> x, y, z;
+
+	[[nodiscard]] size_t size() const {
+		return x.size();
+	}
+
+	/// Copy the given points into SoA layout.
+	static PointsSoA from(const std::vector<Eigen::Vector3d> &points);
+
+	/// The unit vectors pointing from the center to the given points, as used by great_circle_angles.
+	static PointsSoA directions_from(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center);
+};
+
+/**
+ * Compute the Euclidean distance from `from` to every point in `points`.
+ *
+ * @param out 	Output array of size points.size().
+ */
+void euclidean_distances(const Eigen::Vector3d &from, const PointsSoA &points, double *out);
+
+/**
+ * Compute the angle (in radians) between the unit vector `from_direction` and every unit vector in `directions`.
+ *
+ * With the directions computed through PointsSoA::directions_from, this equals GreatCircleMetric::measure.
+ *
+ * @param out 	Output array of size directions.size().
+ */
+void great_circle_angles(const Eigen::Vector3d &from_direction, const PointsSoA &directions, double *out);
+
+#endif //NEW_PLANNERS_DISTANCE_KERNELS_H
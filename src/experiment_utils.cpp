@@ -8,6 +8,7 @@
 #include "../src/probe_retreat_move.h"
 #include "../src/GreatCircleMetric.h"
 #include "../src/experiment_utils.h"
+#include "../src/ApproachDirectionGoal.h"
 #include <boost/range/adaptor/transformed.hpp>
 #include <execution>
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
@@ -111,13 +112,19 @@ moveit::core::RobotModelPtr loadRobotModel() {
 }
 
 std::vector<std::shared_ptr<ompl::base::GoalSampleableRegion>>
-constructAppleGoals(const std::shared_ptr<ompl::base::SpaceInformation> &si, const std::vector<Apple> &apples) {
+constructAppleGoals(const std::shared_ptr<ompl::base::SpaceInformation> &si,
+                    const std::vector<Apple> &apples,
+                    bool learnApproachDirections) {
     static const double GOAL_END_EFFECTOR_RADIUS = 0.01;
 
     std::vector<std::shared_ptr<ompl::base::GoalSampleableRegion>> goals;
-    for (const auto &apple: apples)
-        goals.push_back(
-                std::make_shared<DroneEndEffectorNearTarget>(si, GOAL_END_EFFECTOR_RADIUS, apple.center));
+    for (const auto &apple: apples) {
+        if (learnApproachDirections) {
+            goals.push_back(std::make_shared<ApproachDirectionGoal>(si, GOAL_END_EFFECTOR_RADIUS, apple));
+        } else {
+            goals.push_back(std::make_shared<DroneEndEffectorNearTarget>(si, GOAL_END_EFFECTOR_RADIUS, apple.center));
+        }
+    }
     return goals;
 }
 
@@ -35,8 +35,16 @@ TreePlanningScene buildPlanningScene(int numberOfApples, moveit::core::RobotMode
 
 moveit::core::RobotModelPtr loadRobotModel();
 
+/**
+ * Construct a goal for every apple.
+ *
+ * @param learnApproachDirections 	Whether to use ApproachDirectionGoal, which learns which approaches are collision-free,
+ * 									rather than plain rejection sampling with DroneEndEffectorNearTarget.
+ */
 std::vector<std::shared_ptr<ompl::base::GoalSampleableRegion>>
-constructAppleGoals(const std::shared_ptr<ompl::base::SpaceInformation> &si, const std::vector<Apple> &apples);
+constructAppleGoals(const std::shared_ptr<ompl::base::SpaceInformation> &si,
+                    const std::vector<Apple> &apples,
+                    bool learnApproachDirections = false);
 
 std::vector<ompl::base::GoalPtr> constructNewAppleGoals(const std::shared_ptr<ompl::base::SpaceInformation> &si, const std::vector<Apple> &apples);
 
@@ -4,6 +4,7 @@
 #include <bullet/HACD/hacdHACD.h>
 #include <boost/range/irange.hpp>
 #include "general_utilities.h"
+#include "thread_rng.h"
 
 /**
  * Given two vector4's, produce a third vector perpendicular to the inputs.
@@ -58,7 +59,7 @@ sampleInformedQuaternion(const Eigen::Quaterniond &qa, const Eigen::Quaterniond
 	assert(abs(rb.norm() - 1.0) < 1.0e-10);
 
 	// Get an RNG for sampling.
-	ompl::RNG rng;
+	auto &rng = thread_ompl_rng();
 
 	// The distance between the two input rotations, defined as the the arc cosine of the dot product.
 	double between_inputs = std::acos(ra.dot(rb));
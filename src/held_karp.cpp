@@ -0,0 +1,165 @@
+#include "held_karp.h"
+#include "general_utilities.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+	/// Layers with fewer subsets than this are processed serially, since for those the threading overhead dominates.
+	const size_t PARALLEL_LAYER_SIZE = 1024;
+
+	/// Predecessor marker for entries whose path comes straight from the start.
+	const uint8_t FROM_START = 255;
+
+	size_t popcount(uint32_t mask) {
+		size_t count = 0;
+		for (; mask != 0; mask &= mask - 1) {
+			++count;
+		}
+		return count;
+	}
+}
+
+bool exact_tsp_supported(const GroupedOpenTsp &problem, size_t max_groups) {
+
+	size_t groups = std::count_if(problem.group_members.begin(), problem.group_members.end(), [](const auto &members) {
+		return !members.empty();
+	});
+
+	return groups <= std::min(max_groups, EXACT_TSP_MAX_GROUPS) && problem.n <= EXACT_TSP_MAX_NODES;
+}
+
+std::vector<size_t> solve_open_tsp_exact(const GroupedOpenTsp &problem, const ompl::base::PlannerTerminationCondition &ptc) {
+
+	if (!exact_tsp_supported(problem)) {
+		throw std::invalid_argument("Problem too large for solve_open_tsp_exact");
+	}
+
+	const size_t n = problem.n;
+
+	// Number the non-empty groups; empty ones can't be visited, so they're left out of the subsets.
+	std::vector<std::vector<size_t>> nodes_of_bit;
+	std::vector<size_t> bit_of_node(n);
+
+	for (const auto &members: problem.group_members) {
+		if (!members.empty()) {
+			for (size_t node: members) {
+				bit_of_node[node] = nodes_of_bit.size();
+			}
+			nodes_of_bit.push_back(members);
+		}
+	}
+
+	const size_t g = nodes_of_bit.size();
+
+	if (g == 0) {
+		return {};
+	}
+
+	const uint32_t full = (uint32_t) ((1u << g) - 1);
+
+	// cost[mask * n + node]: length of the shortest path from the start through one node of every group in mask,
+	// ending at node (whose group must be in mask); parent holds the node before it.
+	std::vector<float> cost(((size_t) full + 1) * n, std::numeric_limits<float>::infinity());
+	std::vector<uint8_t> parent(cost.size(), FROM_START);
+
+	for (size_t node = 0; node < n; ++node) {
+		cost[((size_t) 1 << bit_of_node[node]) * n + node] = (float) problem.distance(problem.start(), node);
+	}
+
+	// Group the subsets by size, since a subset only depends on subsets with one group less.
+	std::vector<std::vector<uint32_t>> layers(g + 1);
+	for (uint32_t mask = 1; mask <= full; ++mask) {
+		layers[popcount(mask)].push_back(mask);
+	}
+
+	auto fill_subset = [&](uint32_t mask) {
+		for (size_t bit = 0; bit < g; ++bit) {
+
+			if ((mask & (1u << bit)) == 0) {
+				continue;
+			}
+
+			const uint32_t previous_mask = mask ^ (1u << bit);
+
+			for (size_t node: nodes_of_bit[bit]) {
+
+				float best = std::numeric_limits<float>::infinity();
+				uint8_t best_previous = FROM_START;
+
+				for (size_t previous_bit = 0; previous_bit < g; ++previous_bit) {
+
+					if ((previous_mask & (1u << previous_bit)) == 0) {
+						continue;
+					}
+
+					for (size_t previous: nodes_of_bit[previous_bit]) {
+						float c = cost[previous_mask * n + previous] + (float) problem.distance(previous, node);
+						if (c < best) {
+							best = c;
+							best_previous = (uint8_t) previous;
+						}
+					}
+				}
+
+				cost[mask * n + node] = best;
+				parent[mask * n + node] = best_previous;
+			}
+		}
+	};
+
+	for (size_t layer = 2; layer <= g; ++layer) {
+
+		if (layers[layer].size() >= PARALLEL_LAYER_SIZE) {
+			// Every subset only writes its own entries, so no synchronization is needed.
+			std::for_each(std::execution::par, layers[layer].begin(), layers[layer].end(), fill_subset);
+		} else {
+			std::for_each(layers[layer].begin(), layers[layer].end(), fill_subset);
+		}
+
+		checkPtc(ptc);
+	}
+
+	// The tour is open-ended, so it can end at whichever node is cheapest.
+	size_t last = 0;
+	for (size_t node = 1; node < n; ++node) {
+		if (cost[full * n + node] < cost[full * n + last]) {
+			last = node;
+		}
+	}
+
+	std::vector<size_t> tour;
+	tour.reserve(g);
+
+	uint32_t mask = full;
+	size_t node = last;
+
+	while (true) {
+		tour.push_back(node);
+
+		uint8_t previous = parent[mask * n + node];
+		mask ^= 1u << bit_of_node[node];
+
+		if (previous == FROM_START) {
+			break;
+		}
+		node = previous;
+	}
+
+	std::reverse(tour.begin(), tour.end());
+
+	// Non-finite costs break the chain of predecessors early; never return a tour that skips groups.
+	std::vector<bool> visited(g, false);
+	for (size_t visited_node: tour) {
+		visited[bit_of_node[visited_node]] = true;
+	}
+
+	if (tour.size() != g || std::find(visited.begin(), visited.end(), false) != visited.end()) {
+		throw std::runtime_error("solve_open_tsp_exact found no finite tour through every group");
+	}
+
+	return tour;
+}
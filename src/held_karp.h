@@ -0,0 +1,34 @@
+#ifndef NEW_PLANNERS_HELD_KARP_H
+#define NEW_PLANNERS_HELD_KARP_H
+
+#include <vector>
+#include <ompl/base/PlannerTerminationCondition.h>
+#include "tsp_local_search.h"
+
+/// Largest number of (non-empty) groups solve_open_tsp_exact accepts; its table has 2^groups * n entries.
+const size_t EXACT_TSP_MAX_GROUPS = 20;
+
+/// Largest number of nodes solve_open_tsp_exact accepts, since predecessors are stored as single bytes.
+const size_t EXACT_TSP_MAX_NODES = 254;
+
+/**
+ * Whether solve_open_tsp_exact accepts the problem; see EXACT_TSP_MAX_GROUPS and EXACT_TSP_MAX_NODES.
+ */
+bool exact_tsp_supported(const GroupedOpenTsp &problem, size_t max_groups = EXACT_TSP_MAX_GROUPS);
+
+/**
+ * Solve the problem to optimality with the Held-Karp dynamic program, over subsets of groups and the node
+ * visited last: O(2^g * n^2) time and O(2^g * n) memory for g groups and n nodes, with a float cost and
+ * a single-byte predecessor per table entry.
+ *
+ * Subsets of equal size only depend on smaller subsets, so every such layer is processed in parallel
+ * (if it is large enough to be worth it).
+ *
+ * @param problem 	The problem; must be supported (see exact_tsp_supported).
+ * @param ptc 		Checked between layers; throws PlanningTimeout if it triggers.
+ * @return The visited nodes, in order; exactly one per non-empty group.
+ * @throws std::runtime_error if no tour with a finite length visits every group.
+ */
+std::vector<size_t> solve_open_tsp_exact(const GroupedOpenTsp &problem, const ompl::base::PlannerTerminationCondition &ptc);
+
+#endif //NEW_PLANNERS_HELD_KARP_H
@@ -0,0 +1,114 @@
+
+#include "k_medoids.h"
+
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+	/// Assign every item to its nearest medoid. Returns whether any assignment changed.
+	bool assign(Clustering &clustering, size_t n, const std::function<double(size_t, size_t)> &distance) {
+
+		bool changed = false;
+
+		for (size_t i = 0; i < n; ++i) {
+
+			size_t nearest = 0;
+			double nearest_distance = std::numeric_limits<double>::infinity();
+
+			for (size_t c = 0; c < clustering.medoids.size(); ++c) {
+				double d = distance(i, clustering.medoids[c]);
+				if (d < nearest_distance) {
+					nearest_distance = d;
+					nearest = c;
+				}
+			}
+
+			if (clustering.assignment[i] != nearest) {
+				clustering.assignment[i] = nearest;
+				changed = true;
+			}
+		}
+
+		for (auto &members: clustering.members) {
+			members.clear();
+		}
+		for (size_t i = 0; i < n; ++i) {
+			clustering.members[clustering.assignment[i]].push_back(i);
+		}
+
+		return changed;
+	}
+
+	/// Move every medoid to the member with the least total distance to the other members.
+	void update_medoids(Clustering &clustering, const std::function<double(size_t, size_t)> &distance) {
+
+		for (size_t c = 0; c < clustering.medoids.size(); ++c) {
+
+			double best_cost = std::numeric_limits<double>::infinity();
+
+			for (size_t candidate: clustering.members[c]) {
+
+				double cost = 0.0;
+				for (size_t other: clustering.members[c]) {
+					cost += distance(candidate, other);
+				}
+
+				if (cost < best_cost) {
+					best_cost = cost;
+					clustering.medoids[c] = candidate;
+				}
+			}
+		}
+	}
+
+}
+
+Clustering k_medoids(size_t n,
+					 size_t k,
+					 const std::function<double(size_t, size_t)> &distance,
+					 size_t first_medoid,
+					 size_t max_iterations) {
+
+	k = std::min(k, n);
+
+	Clustering clustering;
+	clustering.assignment.assign(n, std::numeric_limits<size_t>::max());
+	clustering.members.resize(k);
+
+	if (k == 0) {
+		return clustering;
+	}
+
+	// Farthest-point traversal: every next medoid is the item farthest from all medoids so far.
+	clustering.medoids.push_back(first_medoid);
+
+	std::vector<double> distance_to_medoids(n);
+	for (size_t i = 0; i < n; ++i) {
+		distance_to_medoids[i] = distance(i, first_medoid);
+	}
+
+	while (clustering.medoids.size() < k) {
+
+		size_t farthest = std::max_element(distance_to_medoids.begin(), distance_to_medoids.end()) - distance_to_medoids.begin();
+		clustering.medoids.push_back(farthest);
+
+		for (size_t i = 0; i < n; ++i) {
+			distance_to_medoids[i] = std::min(distance_to_medoids[i], distance(i, farthest));
+		}
+	}
+
+	for (size_t iteration = 0; iteration < max_iterations; ++iteration) {
+
+		if (!assign(clustering, n, distance) && iteration > 0) {
+			break;
+		}
+
+		update_medoids(clustering, distance);
+	}
+
+	// Make sure the members reflect the final medoids.
+	assign(clustering, n, distance);
+
+	return clustering;
+}
@@ -0,0 +1,37 @@
+#ifndef NEW_PLANNERS_K_MEDOIDS_H
+#define NEW_PLANNERS_K_MEDOIDS_H
+
+#include <vector>
+#include <functional>
+
+/**
+ * The result of clustering n items into k clusters.
+ */
+struct Clustering {
+	/// The item at the center of each cluster.
+	std::vector<size_t> medoids;
+	/// The cluster each item belongs to.
+	std::vector<size_t> assignment;
+	/// The items in each cluster.
+	std::vector<std::vector<size_t>> members;
+};
+
+/**
+ * Cluster items into k clusters using k-medoids (alternating assignment and medoid update),
+ * which, unlike k-means, only needs a distance function and so works with any metric.
+ *
+ * Initial medoids are chosen by farthest-point traversal from the given first medoid, which keeps the result deterministic.
+ *
+ * @param n 				Number of items.
+ * @param k 				Number of clusters; clamped to n.
+ * @param distance 			Symmetric distance between two items.
+ * @param first_medoid 		The item to seed the farthest-point traversal with.
+ * @param max_iterations 	Upper bound on assignment/update rounds.
+ */
+Clustering k_medoids(size_t n,
+					 size_t k,
+					 const std::function<double(size_t, size_t)> &distance,
+					 size_t first_medoid = 0,
+					 size_t max_iterations = 20);
+
+#endif //NEW_PLANNERS_K_MEDOIDS_H
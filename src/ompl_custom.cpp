@@ -7,6 +7,8 @@
 #include "DroneStateConstraintSampler.h"
 #include "ompl_custom.h"
 #include "UnionGoalSampleableRegion.h"
+#include "GoalStatePool.h"
+#include "DroneStateView.h"
 
 bool StateValidityChecker::isValid(const ompl::base::State *state) const {
 
@@ -53,9 +55,22 @@ DroneEndEffectorNearTarget::DroneEndEffectorNearTarget(const ompl::base::SpaceIn
 }
 
 void DroneEndEffectorNearTarget::sampleGoal(ompl::base::State *state) const {
-    auto *state_space = si_->getStateSpace()->as<DroneStateSpace>();
+    if (!samplePooled(state)) {
+        sampleGoalLive(state);
+    }
+}
 
-    moveit::core::RobotState st(state_space->getRobotModel());
+bool DroneEndEffectorNearTarget::samplePooled(ompl::base::State *state) const {
+    return state_pool && state_pool->take(*this, state);
+}
+
+void DroneEndEffectorNearTarget::setStatePool(std::shared_ptr<GoalStatePool> pool) {
+    state_pool = std::move(pool);
+}
+
+bool DroneEndEffectorNearTarget::sampleGoalLive(ompl::base::State *state) const {
+    // Sample in place; a single forward kinematics pass per attempt.
+    DroneStateView st(*si_->getStateSpace()->as<DroneStateSpace>(), state);
 
     const size_t ATTEMPTS_BEFORE_GIVE_UP = 100;
 
@@ -64,12 +79,11 @@ void DroneEndEffectorNearTarget::sampleGoal(ompl::base::State *state) const {
     do {
         randomizeUprightWithBase(st, 20.0);
         moveEndEffectorToGoal(st, radius, target);
-        state_space->as<DroneStateSpace>()->copyToOMPLState(state, st);
         samples_tried += 1;
 
         if (attempts_this_time++ > ATTEMPTS_BEFORE_GIVE_UP) {
             OMPL_WARN("Goal sampling failed after %d attempts. Giving up.", ATTEMPTS_BEFORE_GIVE_UP);
-            return;
+            return false;
         }
 
     } while (!si_->isValid(state));
@@ -77,14 +91,13 @@ void DroneEndEffectorNearTarget::sampleGoal(ompl::base::State *state) const {
     assert(this->isSatisfied(state));
 
     samples_yielded += 1;
+
+    return true;
 }
 
 double DroneEndEffectorNearTarget::distanceGoal(const ompl::base::State *state) const {
-    auto *state_space = si_->getStateSpace()->as<DroneStateSpace>();
-    moveit::core::RobotState st(state_space->getRobotModel());
-    state_space->copyToRobotState(st, state);
-
-    Eigen::Vector3d ee_pos = st.getGlobalLinkTransform("end_effector").translation();
+    Eigen::Vector3d ee_pos = DroneStateView::of(*si_->getStateSpace()->as<DroneStateSpace>(), state)
+            .linkTransform("end_effector").translation();
 
     Eigen::Vector3d delta = target - ee_pos;
 
@@ -124,18 +137,42 @@ initSpaceInformation(const planning_scene::PlanningSceneConstPtr &scene,
     return si;
 }
 
+DroneStateLayout::DroneStateLayout(const moveit::core::JointModelGroup &group) : base(0) {
+
+    bool has_base = false;
+
+    for (const auto *jm: group.getActiveJointModels()) {
+        for (const auto &variable: jm->getVariableNames()) {
+            const auto index = (size_t) group.getVariableGroupIndex(variable);
+
+            if (jm->getType() != moveit::core::JointModel::FLOATING) {
+                arm.push_back(index);
+                arm_bounds.push_back(jm->getVariableBounds(variable));
+            } else if (!has_base) {
+                base = index;
+                has_base = true;
+            }
+        }
+    }
+
+    if (!has_base) {
+        throw std::runtime_error("The drone must have a floating base.");
+    }
+}
+
 double DroneStateSpace::getMeasure() const {
 
-    double measure = 0.0;
+    double measure = 1.0;
 
     for (auto jm : this->getRobotModel()->getActiveJointModels()) {
         switch (jm->getType()) {
             case moveit::core::JointModel::REVOLUTE:
             case moveit::core::JointModel::PRISMATIC:
-                measure += jm->getVariableBounds()[0].min_position_ - jm->getVariableBounds()[0].max_position_;
+                measure *= jm->getVariableBounds()[0].max_position_ - jm->getVariableBounds()[0].min_position_;
                 break;
             case moveit::core::JointModel::FLOATING:
-                measure += translation_bound*translation_bound*translation_bound/2.0 + 2.0*M_PI;
+                // The translation box (2b * 2b * b), times the yaw; the base is kept upright.
+                measure *= 4.0 * translation_bound * translation_bound * translation_bound * 2.0 * M_PI;
                 break;
             case moveit::core::JointModel::FIXED:
                 // do nothing.
@@ -3,6 +3,7 @@
 #ifndef NEW_PLANNERS_OMPL_CUSTOM_H
 #define NEW_PLANNERS_OMPL_CUSTOM_H
 
+#include <atomic>
 #include <utility>
 #include <ompl/base/goals/GoalSampleableRegion.h>
 #include <ompl/base/MotionValidator.h>
@@ -30,13 +31,28 @@ public:
 
 };
 
+/**
+ * Where the variables of the drone are within the values of a DroneStateSpace::StateType (see DroneStateView).
+ */
+struct DroneStateLayout {
+    /// Index of the first base variable; the base has x, y, z, followed by the quaternion qx, qy, qz, qw.
+    size_t base;
+    /// Indices of the arm joint variables, in the order of the robot model.
+    std::vector<size_t> arm;
+    /// Bounds of the arm joint variables, in the same order.
+    std::vector<moveit::core::VariableBounds> arm_bounds;
+
+    explicit DroneStateLayout(const moveit::core::JointModelGroup &group);
+};
+
 class DroneStateSpace : public ompl_interface::ModelBasedStateSpace {
 
     double translation_bound;
     const std::string param_type_ = "custom";
+    DroneStateLayout layout;
 public:
     explicit DroneStateSpace(const ompl_interface::ModelBasedStateSpaceSpecification &spec, double translation_bound = 20.0)
-            : ModelBasedStateSpace(spec), translation_bound(translation_bound) {}
+            : ModelBasedStateSpace(spec), translation_bound(translation_bound), layout(*spec.joint_model_group_) {}
 
     unsigned int validSegmentCount(const ompl::base::State *state1, const ompl::base::State *state2) const override {
         return (int) std::ceil(this->distance(state1, state2) / 0.2);
@@ -50,8 +66,18 @@ public:
         return std::make_shared<DroneStateSampler>(this, translation_bound);
     }
 
+    /// The measure of the upright configurations within the translation bound: the product of the measures of the joints.
     [[nodiscard]] double getMeasure() const override;
 
+    /// The base translates within [-b, b] x [-b, b] x [0, b], with b the translation bound (see DroneStateSampler).
+    [[nodiscard]] double getTranslationBound() const {
+        return translation_bound;
+    }
+
+    [[nodiscard]] const DroneStateLayout &getLayout() const {
+        return layout;
+    }
+
 };
 
 class InverseClearanceIntegralObjectiveOMPL : public ompl::base::StateCostIntegralObjective {
@@ -63,20 +89,26 @@ public:
 
 };
 
+class GoalStatePool;
+
 class DroneEndEffectorNearTarget : public ompl::base::GoalSampleableRegion {
 
     double radius;
     Eigen::Vector3d target;
+
+    /// If set, sampleGoal takes states from here before falling back to sampleGoalLive.
+    std::shared_ptr<GoalStatePool> state_pool;
 public:
     double getRadius() const;
 
     const Eigen::Vector3d &getTarget() const;
 
-private:
+protected:
 
-    // Just for statistics, doesn't affect functionality, so it's mutable.
-    mutable size_t samples_yielded = 0;
-    mutable size_t samples_tried = 0;
+    // Just for statistics, doesn't affect functionality, so it's mutable. Atomic, since goals are sampled
+    // from several threads, and the counts are read while sampling (see AdaptiveUnionGoalSampleableRegion).
+    mutable std::atomic<size_t> samples_yielded{0};
+    mutable std::atomic<size_t> samples_tried{0};
 
 public:
     size_t getSamplesYielded() const;
@@ -85,8 +117,27 @@ public:
 
     DroneEndEffectorNearTarget(const ompl::base::SpaceInformationPtr &si, double radius, const Eigen::Vector3d &target);
 
+    /**
+     * Take a precomputed state from the pool if there is one left, otherwise sample one with sampleGoalLive.
+     */
     void sampleGoal(ompl::base::State *state) const override;
 
+    /**
+     * Sample a goal state by rejection sampling, ignoring the pool.
+     *
+     * @return Whether the state is valid; if the sampler gave up, it is left invalid.
+     */
+    virtual bool sampleGoalLive(ompl::base::State *state) const;
+
+    /**
+     * Take a precomputed valid goal state from the pool, if one is set and it has any left for this target.
+     *
+     * @return Whether a state was written.
+     */
+    bool samplePooled(ompl::base::State *state) const;
+
+    void setStatePool(std::shared_ptr<GoalStatePool> pool);
+
     [[nodiscard]] unsigned int maxSampleCount() const override;
 
     double distanceGoal(const ompl::base::State *state) const override;
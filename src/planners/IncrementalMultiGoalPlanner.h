@@ -0,0 +1,46 @@
+#ifndef NEW_PLANNERS_INCREMENTALMULTIGOALPLANNER_H
+#define NEW_PLANNERS_INCREMENTALMULTIGOALPLANNER_H
+
+#include "MultiGoalPlanner.h"
+
+/**
+ * A multi-goal planner that keeps its state between planning calls, such that the goal set and start state
+ * can be changed part-way through a mission (apples picked, failed to pick, or newly detected),
+ * and only the affected parts of the plan need to be recomputed.
+ *
+ * Goals are referred to by the identifiers handed out by addGoals(); the `to_goal_id_` fields of the
+ * PathSegments in a PlanResult refer to these identifiers as well.
+ */
+class IncrementalMultiGoalPlanner {
+
+public:
+	/**
+	 * Add goals to be visited. Nothing is planned until the next call to replan().
+	 *
+	 * @return 	Identifiers of the new goals, in the same order as the given goals.
+	 */
+	virtual std::vector<size_t> addGoals(const std::vector<ompl::base::GoalPtr> &goals) = 0;
+
+	/**
+	 * Remove goals (for instance, because the apple was picked). Unknown identifiers are ignored.
+	 */
+	virtual void removeGoals(const std::vector<size_t> &goal_ids) = 0;
+
+	/**
+	 * Change the state from which the plan starts (for instance, the current state of the robot).
+	 */
+	virtual void updateStart(const ompl::base::State *start) = 0;
+
+	/**
+	 * Bring the plan up-to-date with the changes since the last call, and return it.
+	 */
+	virtual MultiGoalPlanner::PlanResult replan(ompl::base::PlannerTerminationCondition &ptc) = 0;
+
+	[[nodiscard]] virtual Json::Value parameters() const = 0;
+
+	[[nodiscard]] virtual std::string name() const = 0;
+
+	virtual ~IncrementalMultiGoalPlanner() = default;
+};
+
+#endif //NEW_PLANNERS_INCREMENTALMULTIGOALPLANNER_H
@@ -0,0 +1,212 @@
+
+#include "IncrementalShellPathPlanner.h"
+#include "../probe_retreat_move.h"
+#include "../DronePathLengthObjective.h"
+#include "../general_utilities.h"
+
+#include <json/json.h>
+
+namespace {
+	/// Erase all entries of a map keyed by goal ID pairs that involve the given goal.
+	template<typename V>
+	void eraseEntriesInvolving(std::map<std::pair<size_t, size_t>, V> &map, size_t goal_id) {
+		for (auto it = map.begin(); it != map.end();) {
+			if (it->first.first == goal_id || it->first.second == goal_id) {
+				it = map.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
+IncrementalShellPathPlanner::IncrementalShellPathPlanner(const ompl::base::SpaceInformationPtr &si,
+														 const ompl::base::State *start,
+														 const AppleTreePlanningScene &planning_scene,
+														 bool applyShellstateOptimization,
+														 std::shared_ptr<SingleGoalPlannerMethods> methods,
+														 const std::function<std::shared_ptr<SphereShell>(
+																 const AppleTreePlanningScene &)> &shellBuilder)
+		: si(si),
+		  shell_planner(applyShellstateOptimization, std::move(methods), shellBuilder),
+		  ompl_shell(shellBuilder(planning_scene), si),
+		  start(si),
+		  tour([this](size_t goal) { return predictedStartDistance(goal); },
+			   [this](size_t goal_a, size_t goal_b) { return predictedDistance(goal_a, goal_b); }) {
+	si->copyState(this->start.get(), start);
+}
+
+std::vector<size_t> IncrementalShellPathPlanner::addGoals(const std::vector<ompl::base::GoalPtr> &new_goals) {
+
+	std::vector<size_t> ids;
+	ids.reserve(new_goals.size());
+
+	for (const auto &goal: new_goals) {
+		goals[next_goal_id] = GoalEntry{goal};
+		ids.push_back(next_goal_id++);
+	}
+
+	return ids;
+}
+
+void IncrementalShellPathPlanner::removeGoals(const std::vector<size_t> &goal_ids) {
+
+	for (size_t goal_id: goal_ids) {
+
+		if (goals.erase(goal_id) == 0) {
+			continue;
+		}
+
+		tour.remove(goal_id);
+
+		predicted_start_distances.erase(goal_id);
+
+		// Identifiers are never re-used, so stale cache entries would be harmless, but they do take up memory.
+		eraseEntriesInvolving(predicted_distances, goal_id);
+		eraseEntriesInvolving(transitions, goal_id);
+
+		if (first_segment && first_segment->first == goal_id) {
+			first_segment.reset();
+		}
+	}
+}
+
+void IncrementalShellPathPlanner::updateStart(const ompl::base::State *new_start) {
+
+	if (si->equalStates(start.get(), new_start)) {
+		return;
+	}
+
+	si->copyState(start.get(), new_start);
+
+	first_segment.reset();
+	predicted_start_distances.clear();
+	start_changed = true;
+}
+
+double IncrementalShellPathPlanner::predictedDistance(size_t goal_a, size_t goal_b) {
+
+	std::pair<size_t, size_t> key = std::minmax(goal_a, goal_b);
+
+	auto it = predicted_distances.find(key);
+	if (it == predicted_distances.end()) {
+		it = predicted_distances.emplace(
+				key,
+				ompl_shell.predict_path_length(goals.at(key.first).goal.get(), goals.at(key.second).goal.get())
+		).first;
+	}
+
+	return it->second;
+}
+
+double IncrementalShellPathPlanner::predictedStartDistance(size_t goal) {
+
+	auto it = predicted_start_distances.find(goal);
+	if (it == predicted_start_distances.end()) {
+		it = predicted_start_distances.emplace(
+				goal,
+				ompl_shell.predict_path_length(start.get(), goals.at(goal).goal.get())
+		).first;
+	}
+
+	return it->second;
+}
+
+void IncrementalShellPathPlanner::planMissingApproaches(ompl::base::PlannerTerminationCondition &ptc) {
+
+	for (auto &[goal_id, entry]: goals) {
+
+		if (entry.approach_planned) {
+			continue;
+		}
+
+		entry.approach = shell_planner.planApproachForGoal(si, ompl_shell, entry.goal);
+		entry.approach_planned = true;
+
+		checkPtc(ptc);
+	}
+}
+
+void IncrementalShellPathPlanner::repairTour() {
+
+	for (const auto &[goal_id, entry]: goals) {
+		if (entry.approach && !tour.contains(goal_id)) {
+			tour.insertCheapest(goal_id);
+		}
+	}
+}
+
+MultiGoalPlanner::PlanResult IncrementalShellPathPlanner::replan(ompl::base::PlannerTerminationCondition &ptc) {
+
+	planMissingApproaches(ptc);
+
+	repairTour();
+
+	if (start_changed) {
+		tour.repairStart();
+		start_changed = false;
+	}
+
+	// Warm-started from the repaired tour, such that it changes no more than necessary,
+	// which keeps the cached transitions useful.
+	tour.improve(ptc);
+
+	MultiGoalPlanner::PlanResult result{{}};
+
+	if (tour.empty()) {
+		return result;
+	}
+
+	if (!first_segment || first_segment->first != tour[0]) {
+
+		auto first_approach = shell_planner.planFirstApproach(start.get(), *goals.at(tour[0]).approach);
+
+		if (!first_approach) {
+			return result;
+		}
+
+		first_segment = {tour[0], *first_approach};
+	}
+
+	result.segments.push_back({first_segment->first, first_segment->second});
+
+	for (size_t i = 1; i < tour.size(); ++i) {
+
+		auto key = std::make_pair(tour[i - 1], tour[i]);
+
+		auto it = transitions.find(key);
+
+		if (it == transitions.end()) {
+
+			// retreat_move_probe indexes into the goal vector, so give it just the two goals involved.
+			std::vector<ompl::base::GoalPtr> pair_goals{goals.at(key.first).goal, goals.at(key.second).goal};
+
+			ompl::geometric::PathGeometric goal_to_goal(si);
+
+			auto segment_path = shell_planner.retreat_move_probe(pair_goals,
+																 ompl_shell,
+																 result,
+																 goal_to_goal,
+																 {0, *goals.at(key.first).approach},
+																 {1, *goals.at(key.second).approach});
+
+			segment_path = optimize(segment_path, std::make_shared<DronePathLengthObjective>(si), si);
+
+			it = transitions.emplace(key, segment_path).first;
+
+			checkPtc(ptc);
+		}
+
+		result.segments.push_back({tour[i], it->second});
+	}
+
+	return result;
+}
+
+Json::Value IncrementalShellPathPlanner::parameters() const {
+	return shell_planner.parameters();
+}
+
+std::string IncrementalShellPathPlanner::name() const {
+	return "IncrementalShellPathPlanner";
+}
@@ -0,0 +1,106 @@
+#ifndef NEW_PLANNERS_INCREMENTALSHELLPATHPLANNER_H
+#define NEW_PLANNERS_INCREMENTALSHELLPATHPLANNER_H
+
+#include <map>
+#include "IncrementalMultiGoalPlanner.h"
+#include "IncrementalTour.h"
+#include "ShellPathPlanner.h"
+
+/**
+ * Incremental version of ShellPathPlanner.
+ *
+ * Approach paths, predicted shell distances, the visiting order and the assembled goal-to-goal segments
+ * are all kept between calls to replan(). New goals get an approach path planned and are inserted into
+ * the existing order at the cheapest position; removed goals are simply cut out of the order.
+ * Only the segments adjacent to a change are re-assembled.
+ *
+ * The tour refers back to the planner for its distances, so the planner can be neither copied nor moved.
+ */
+class IncrementalShellPathPlanner : public IncrementalMultiGoalPlanner {
+
+	/// Everything we know about a goal.
+	struct GoalEntry {
+		ompl::base::GoalPtr goal;
+		/// Whether planning the approach has been attempted.
+		bool approach_planned = false;
+		/// The approach path (shell to goal), if planning it succeeded.
+		std::optional<ompl::geometric::PathGeometric> approach;
+	};
+
+	ompl::base::SpaceInformationPtr si;
+
+	/// Used for planning and assembling the individual pieces of the path.
+	ShellPathPlanner shell_planner;
+
+	OMPLSphereShellWrapper ompl_shell;
+
+	ompl::base::ScopedState<> start;
+
+	/// All goals, by identifier.
+	std::map<size_t, GoalEntry> goals;
+
+	/// The identifier to be given to the next goal.
+	size_t next_goal_id = 0;
+
+	/// The current visiting order, only containing goals with an approach path.
+	IncrementalTour tour;
+
+	/// Memoized shell path length predictions between goals, keyed by (min_id, max_id).
+	std::map<std::pair<size_t, size_t>, double> predicted_distances;
+
+	/// Memoized shell path length predictions from the current start state to goals.
+	std::map<size_t, double> predicted_start_distances;
+
+	/// The path from the start state to the first goal, if still valid.
+	std::optional<std::pair<size_t, ompl::geometric::PathGeometric>> first_segment;
+
+	/// Assembled goal-to-goal paths, keyed by (from_id, to_id).
+	std::map<std::pair<size_t, size_t>, ompl::geometric::PathGeometric> transitions;
+
+	/// Whether the start state changed since the last replan.
+	bool start_changed = true;
+
+	double predictedDistance(size_t goal_a, size_t goal_b);
+
+	double predictedStartDistance(size_t goal);
+
+	/// Plan the approaches for any goals that don't have one yet.
+	void planMissingApproaches(ompl::base::PlannerTerminationCondition &ptc);
+
+	/// Cheapest-insert the goals that have an approach path but are not in the tour yet.
+	void repairTour();
+
+public:
+	/**
+	 * @param si 							The space information to plan in.
+	 * @param start 						The initial start state.
+	 * @param planning_scene 				The scene, used to construct the shell.
+	 * @param applyShellstateOptimization 	See ShellPathPlanner.
+	 * @param methods 						See ShellPathPlanner.
+	 * @param shellBuilder 					See ShellPathPlanner.
+	 */
+	IncrementalShellPathPlanner(const ompl::base::SpaceInformationPtr &si,
+								const ompl::base::State *start,
+								const AppleTreePlanningScene &planning_scene,
+								bool applyShellstateOptimization,
+								std::shared_ptr<SingleGoalPlannerMethods> methods,
+								const std::function<std::shared_ptr<SphereShell>(const AppleTreePlanningScene &)> &shellBuilder);
+
+	IncrementalShellPathPlanner(const IncrementalShellPathPlanner &) = delete;
+
+	IncrementalShellPathPlanner &operator=(const IncrementalShellPathPlanner &) = delete;
+
+	std::vector<size_t> addGoals(const std::vector<ompl::base::GoalPtr> &new_goals) override;
+
+	void removeGoals(const std::vector<size_t> &goal_ids) override;
+
+	void updateStart(const ompl::base::State *new_start) override;
+
+	MultiGoalPlanner::PlanResult replan(ompl::base::PlannerTerminationCondition &ptc) override;
+
+	[[nodiscard]] Json::Value parameters() const override;
+
+	[[nodiscard]] std::string name() const override;
+};
+
+#endif //NEW_PLANNERS_INCREMENTALSHELLPATHPLANNER_H
@@ -0,0 +1,112 @@
+#include "IncrementalTour.h"
+#include "../tsp_local_search.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+IncrementalTour::IncrementalTour(StartDistanceFn fromStart, DistanceFn between)
+		: from_start(std::move(fromStart)), between(std::move(between)) {
+}
+
+void IncrementalTour::insertCheapest(size_t goal_id) {
+
+	size_t best_position = 0;
+	double best_increase = std::numeric_limits<double>::infinity();
+
+	for (size_t position = 0; position <= order.size(); ++position) {
+
+		double before = position == 0 ? from_start(goal_id) : between(order[position - 1], goal_id);
+
+		double increase = before;
+
+		if (position < order.size()) {
+			increase += between(goal_id, order[position]);
+			increase -= position == 0 ? from_start(order[position]) : between(order[position - 1], order[position]);
+		}
+
+		if (increase < best_increase) {
+			best_increase = increase;
+			best_position = position;
+		}
+	}
+
+	order.insert(order.begin() + (long) best_position, goal_id);
+}
+
+void IncrementalTour::remove(size_t goal_id) {
+	order.erase(std::remove(order.begin(), order.end(), goal_id), order.end());
+}
+
+void IncrementalTour::repairStart() {
+
+	if (order.size() < 2) {
+		return;
+	}
+
+	// Reversing the prefix order[0..=j] replaces the edges (start, order[0]) and (order[j], order[j+1])
+	// by (start, order[j]) and (order[0], order[j+1]); the rest of the tour is unaffected.
+	size_t best_j = 0;
+	double best_gain = 0.0;
+
+	for (size_t j = 1; j < order.size(); ++j) {
+
+		double removed = from_start(order[0]);
+		double added = from_start(order[j]);
+
+		if (j + 1 < order.size()) {
+			removed += between(order[j], order[j + 1]);
+			added += between(order[0], order[j + 1]);
+		}
+
+		if (removed - added > best_gain) {
+			best_gain = removed - added;
+			best_j = j;
+		}
+	}
+
+	if (best_j > 0) {
+		std::reverse(order.begin(), order.begin() + (long) best_j + 1);
+	}
+}
+
+void IncrementalTour::improve(const ompl::base::PlannerTerminationCondition &ptc) {
+
+	if (order.size() < 3) {
+		return;
+	}
+
+	auto problem = GroupedOpenTsp::build([&](size_t i) {
+		return from_start(order[i]);
+	}, [&](size_t i, size_t j) {
+		return between(order[i], order[j]);
+	}, std::vector<size_t>(order.size(), 1), ptc);
+
+	std::vector<size_t> current_order(order.size());
+	std::iota(current_order.begin(), current_order.end(), 0);
+
+	std::vector<size_t> improved;
+	improved.reserve(order.size());
+	for (size_t i: solve_open_tsp_local_search(problem, ptc, current_order)) {
+		improved.push_back(order[i]);
+	}
+
+	order = std::move(improved);
+}
+
+bool IncrementalTour::contains(size_t goal_id) const {
+	return std::find(order.begin(), order.end(), goal_id) != order.end();
+}
+
+double IncrementalTour::predictedLength() const {
+
+	if (order.empty()) {
+		return 0.0;
+	}
+
+	double length = from_start(order[0]);
+	for (size_t i = 1; i < order.size(); ++i) {
+		length += between(order[i - 1], order[i]);
+	}
+	return length;
+}
@@ -0,0 +1,69 @@
+#ifndef NEW_PLANNERS_INCREMENTALTOUR_H
+#define NEW_PLANNERS_INCREMENTALTOUR_H
+
+#include <functional>
+#include <vector>
+#include <ompl/base/PlannerTerminationCondition.h>
+
+/**
+ * The visiting order of an IncrementalShellPathPlanner: an open tour from the start over a changing set of goals.
+ *
+ * The order is kept up-to-date as goals are added and removed and as the start moves, while changing it
+ * no more than necessary, such that cached goal-to-goal segments stay useful. Goals are identified by
+ * the planner's goal IDs; distances come from callbacks, which are called often and should be memoized.
+ */
+class IncrementalTour {
+
+public:
+	typedef std::function<double(size_t)> StartDistanceFn;
+	typedef std::function<double(size_t, size_t)> DistanceFn;
+
+private:
+	StartDistanceFn from_start;
+	DistanceFn between;
+
+	/// Goal IDs, in visiting order.
+	std::vector<size_t> order;
+
+public:
+	/**
+	 * @param fromStart 	Predicted path length from the start to the given goal.
+	 * @param between 		Predicted path length between two goals (symmetric).
+	 */
+	IncrementalTour(StartDistanceFn fromStart, DistanceFn between);
+
+	/// Insert a goal at the position where it increases the predicted length the least.
+	void insertCheapest(size_t goal_id);
+
+	/// Cut a goal out of the order, keeping the order of the rest; unknown goals are ignored.
+	void remove(size_t goal_id);
+
+	/// After the start moved: reverse the prefix of the order that, reversed, shortens the tour the most, if any does.
+	void repairStart();
+
+	/// Improve the order with local search, warm-started from the current order (see solve_open_tsp_local_search).
+	void improve(const ompl::base::PlannerTerminationCondition &ptc);
+
+	[[nodiscard]] bool contains(size_t goal_id) const;
+
+	/// The predicted length of the tour.
+	[[nodiscard]] double predictedLength() const;
+
+	[[nodiscard]] const std::vector<size_t> &getOrder() const {
+		return order;
+	}
+
+	[[nodiscard]] bool empty() const {
+		return order.empty();
+	}
+
+	[[nodiscard]] size_t size() const {
+		return order.size();
+	}
+
+	size_t operator[](size_t i) const {
+		return order[i];
+	}
+};
+
+#endif //NEW_PLANNERS_INCREMENTALTOUR_H
@@ -6,6 +6,7 @@
 #include "../ompl_custom.h"
 #include "../traveling_salesman.h"
 #include "../probe_retreat_move.h"
+#include "PRMCustom.h"
 
 #include <range/v3/all.hpp>
 
@@ -15,66 +16,6 @@ using namespace ranges;
 
 typedef std::vector<std::vector<ob::PathPtr>> PathMatrix;
 
-class PRMCustom : public og::PRMstar {
-
-public:
-    explicit PRMCustom(const ompl::base::SpaceInformationPtr &si) : PRMstar(si) {}
-
-    std::vector<Vertex> tryConnectGoal(ob::GoalSampleableRegion &goal_region, size_t max_samples) {
-
-        std::vector<Vertex> result;
-        
-        for (size_t i = 0; i < max_samples; ++i) {
-            ob::State *st = si_->allocState();
-
-            goal_region.sampleGoal(st);
-
-            if (si_->isValid(st)) {
-                result.push_back(addMilestone(st)); // PRM takes ownership of the pointer
-            } else {
-                si_->freeState(st);
-                break;
-            }
-            
-        }
-        
-        return result;
-        
-    }
-
-    Vertex insert_state(const ob::State *st) {
-        ob::State *st_copy = si_->allocState();
-        si_->copyState(st_copy, st);
-        return addMilestone(st_copy); // PRM takes ownership of the pointer
-    }
-
-    /**
-     * Try to connect two vertices/states with a path. As an added optimization,
-     * first check if the two vertices are even in the same component.
-     *
-     * @param u Start vertex
-     * @param v End vertex
-     * @return A path if one exists, or nullptr otherwise
-     */
-    ob::PathPtr path_distance(Vertex start, Vertex goal) {
-        assert(same_component(start, goal));
-
-        if (start == goal) {
-            return std::make_shared<og::PathGeometric>(si_, stateProperty_[start]);
-        } else {
-            return constructSolution({start}, {goal});
-        }
-    }
-
-    bool same_component(Vertex v, Vertex u) {
-        graphMutex_.lock();
-        bool same_component = sameComponent(v, u);
-        graphMutex_.unlock();
-        return same_component;
-    }
-
-};
-
 struct AppleIdVertexPair {
     size_t apple_id;
     std::vector<PRMCustom::Vertex> vertex;
@@ -147,14 +88,27 @@ MultiGoalPlanner::PlanResult MultigoalPrmStar::plan(const ompl::base::SpaceInfor
 
     std::cout << "Solving TSP..." << std::endl;
 
-    auto ordering = tsp_open_end_grouped([&](auto pair) {
+    auto from_start = [&](auto pair) {
 		auto path = prm->path_distance(start_state_node, goalVertices[pair.first].vertex[pair.second]);
 		return path ? path->length() : std::numeric_limits<double>::infinity();
-	}, [&](auto pair_i, auto pair_j) {
+	};
+
+    auto between = [&](auto pair_i, auto pair_j) {
 		auto path = prm->path_distance(goalVertices[pair_i.first].vertex[pair_i.second],
 									   goalVertices[pair_j.first].vertex[pair_j.second]);
 		return path ? path->length() : std::numeric_limits<double>::infinity();
-	}, goalVertices | views::transform([&](auto v) { return v.vertex.size(); }) | to_vector, ptc);
+	};
+
+    auto sizes = goalVertices | views::transform([&](auto v) { return v.vertex.size(); }) | to_vector;
+
+    // Every roadmap path is at least as long as the state-space distance between its endpoints,
+    // so that distance is a valid lower bound that does not require a graph search.
+    auto ordering = tsp_options.lazy_distances
+			? tsp_open_end_grouped_lazy(from_start, between, [&](auto pair_i, auto pair_j) {
+				return si->distance(prm->vertex_state(goalVertices[pair_i.first].vertex[pair_i.second]),
+									prm->vertex_state(goalVertices[pair_j.first].vertex[pair_j.second]));
+			}, sizes, ptc, tsp_options)
+			: tsp_open_end_grouped(from_start, between, sizes, ptc, tsp_options);
 
     std::cout << "Building final path" << std::endl;
 
@@ -187,14 +141,15 @@ MultiGoalPlanner::PlanResult MultigoalPrmStar::plan(const ompl::base::SpaceInfor
     return result;
 }
 
-MultigoalPrmStar::MultigoalPrmStar(double prmBuildTime, size_t samplesPerGoal, bool optimizeSegments) : prm_build_time(
-        prmBuildTime), samplesPerGoal(samplesPerGoal), optimize_segments(optimizeSegments) {}
+MultigoalPrmStar::MultigoalPrmStar(double prmBuildTime, size_t samplesPerGoal, bool optimizeSegments, TspOptions tspOptions) : prm_build_time(
+        prmBuildTime), samplesPerGoal(samplesPerGoal), optimize_segments(optimizeSegments), tsp_options(tspOptions) {}
 
 Json::Value MultigoalPrmStar::parameters() const {
     Json::Value params;
     params["prm_build_time"] = prm_build_time;
     params["samples_per_goal"] = (int) samplesPerGoal;
     params["optimize_segments"] = optimize_segments;
+    params["tsp"] = tsp_options.parameters();
     return params;
 }
 
@@ -10,6 +10,7 @@
 #include "../experiment_utils.h"
 #include "../procedural_tree_generation.h"
 #include "MultiGoalPlanner.h"
+#include "../traveling_salesman.h"
 
 MultiApplePlanResult
 planByApples(const moveit::core::RobotState &start_state, const planning_scene::PlanningSceneConstPtr &scene,
@@ -20,8 +21,9 @@ class MultigoalPrmStar : public MultiGoalPlanner {
     double prm_build_time;
     size_t samplesPerGoal;
     bool optimize_segments;
+	TspOptions tsp_options;
 public:
-    MultigoalPrmStar(double prmBuildTime, size_t samplesPerGoal, bool optimizeSegments);
+    MultigoalPrmStar(double prmBuildTime, size_t samplesPerGoal, bool optimizeSegments, TspOptions tspOptions = {});
 
 public:
     PlanResult plan(const ompl::base::SpaceInformationPtr &si,
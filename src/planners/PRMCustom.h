@@ -0,0 +1,146 @@
+#ifndef NEW_PLANNERS_PRMCUSTOM_H
+#define NEW_PLANNERS_PRMCUSTOM_H
+
+#include <ompl/geometric/planners/prm/PRMstar.h>
+#include <ompl/base/goals/GoalSampleableRegion.h>
+#include "../batch_sampling.h"
+#include "../UnionGoalSampleableRegion.h"
+
+/**
+ * A PRM* that exposes enough of its internals to be used as a persistent roadmap
+ * that many start/goal queries are answered against, rather than as a one-shot planner.
+ */
+class PRMCustom : public ompl::geometric::PRMstar {
+
+    /// Sampler for growRoadmapBatch; a plain state sampler, since the batch is validity-checked as a whole.
+    ompl::base::StateSamplerPtr batch_sampler_;
+
+    /// Whether batches are validity-checked in parallel; see setParallelValidityChecking.
+    bool parallel_validity_ = false;
+
+    /// Add the valid states as milestones, and free the others.
+    std::vector<Vertex> addValidMilestones(const std::vector<ompl::base::State *> &states) {
+
+        std::vector<Vertex> result;
+
+        auto valid = check_validity_batch(*si_, states, parallel_validity_);
+
+        for (size_t i = 0; i < states.size(); ++i) {
+            if (valid[i]) {
+                result.push_back(addMilestone(states[i])); // PRM takes ownership of the pointer
+            } else {
+                si_->freeState(states[i]);
+            }
+        }
+
+        return result;
+    }
+
+public:
+    explicit PRMCustom(const ompl::base::SpaceInformationPtr &si) : PRMstar(si) {}
+
+    /**
+     * Check the validity of batches of states (in tryConnectGoal and growRoadmapBatch) in parallel.
+     * Off by default: only enable it if the validity checker is safe to call from multiple threads at once.
+     */
+    void setParallelValidityChecking(bool parallel) {
+        parallel_validity_ = parallel;
+    }
+
+    void clear() override {
+        PRMstar::clear();
+        batch_sampler_.reset();
+    }
+
+    /**
+     * Sample goal states and add the valid ones to the roadmap; the samples are validity-checked
+     * as a batch (see setParallelValidityChecking).
+     */
+    std::vector<Vertex> tryConnectGoal(ompl::base::GoalSampleableRegion &goal_region, size_t max_samples) {
+
+        std::vector<ompl::base::State *> states(max_samples);
+
+        // A single failed sample says little about the next one, so all of them are tried.
+        for (auto &st: states) {
+            st = si_->allocState();
+            goal_region.sampleGoal(st);
+        }
+
+        auto vertices = addValidMilestones(states);
+
+        // Let an adaptive union of goals know which of its samples made it into the roadmap connected.
+        if (auto adaptive = dynamic_cast<AdaptiveUnionGoalSampleableRegion *>(&goal_region)) {
+            for (const auto &v: vertices) {
+                adaptive->reportConnection(stateProperty_[v], boost::out_degree(v, g_) > 0);
+            }
+        }
+
+        return vertices;
+
+    }
+
+    /**
+     * Like growRoadmap, but samples `batch_size` states at a time (see sample_uniform_batch) and checks
+     * their validity as a batch (see setParallelValidityChecking).
+     */
+    void growRoadmapBatch(const ompl::base::PlannerTerminationCondition &ptc, size_t batch_size = 32) {
+
+        if (!isSetup()) {
+            setup();
+        }
+
+        if (!batch_sampler_) {
+            batch_sampler_ = si_->allocStateSampler();
+        }
+
+        std::vector<ompl::base::State *> states(batch_size);
+
+        while (!ptc) {
+            for (auto &st: states) {
+                st = si_->allocState();
+            }
+
+            sample_uniform_batch(*batch_sampler_, states);
+
+            addValidMilestones(states);
+        }
+    }
+
+    Vertex insert_state(const ompl::base::State *st) {
+        ompl::base::State *st_copy = si_->allocState();
+        si_->copyState(st_copy, st);
+        return addMilestone(st_copy); // PRM takes ownership of the pointer
+    }
+
+    /**
+     * Try to connect two vertices/states with a path. As an added optimization,
+     * first check if the two vertices are even in the same component.
+     *
+     * @param u Start vertex
+     * @param v End vertex
+     * @return A path if one exists, or nullptr otherwise
+     */
+    ompl::base::PathPtr path_distance(Vertex start, Vertex goal) {
+        assert(same_component(start, goal));
+
+        if (start == goal) {
+            return std::make_shared<ompl::geometric::PathGeometric>(si_, stateProperty_[start]);
+        } else {
+            return constructSolution({start}, {goal});
+        }
+    }
+
+    const ompl::base::State *vertex_state(Vertex v) const {
+        return stateProperty_[v];
+    }
+
+    bool same_component(Vertex v, Vertex u) {
+        graphMutex_.lock();
+        bool same_component = sameComponent(v, u);
+        graphMutex_.unlock();
+        return same_component;
+    }
+
+};
+
+#endif //NEW_PLANNERS_PRMCUSTOM_H
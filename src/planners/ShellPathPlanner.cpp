@@ -8,16 +8,63 @@
 #include "../DronePathLengthObjective.h"
 #include "../planning_scene_diff_message.h"
 #include "../experiment_utils.h"
+#include "../general_utilities.h"
 
+#include <algorithm>
 #include <utility>
+#include <numeric>
+#include <json/json.h>
 
 
 
+namespace {
+	Eigen::Vector3d endEffectorPosition(const ompl::base::SpaceInformationPtr &si, const ompl::base::State *state) {
+		auto ss = si->getStateSpace()->as<DroneStateSpace>();
+		moveit::core::RobotState st(ss->getRobotModel());
+		ss->copyToRobotState(st, state);
+		return st.getGlobalLinkTransform("end_effector").translation();
+	}
+}
+
 ShellPathPlanner::ShellPathPlanner(bool applyShellstateOptimization,
 								   std::shared_ptr<SingleGoalPlannerMethods> methods,
-								   MakeShellFn& shellBuilder) :
+								   MakeShellFn& shellBuilder,
+								   bool useSharedRoadmap,
+								   std::shared_ptr<ApproachPathCache> approachCache,
+								   TspOptions tspOptions) :
 		apply_shellstate_optimization(applyShellstateOptimization),
-		methods(std::move(methods)), shell_builder(shellBuilder) {}
+		methods(std::move(methods)), shell_builder(shellBuilder),
+		use_shared_roadmap(useSharedRoadmap), approach_cache(std::move(approachCache)),
+		tsp_options(tspOptions) {}
+
+void ShellPathPlanner::setExperienceStore(std::shared_ptr<ExperienceStore> experienceStore) {
+	experience_store = std::move(experienceStore);
+}
+
+void ShellPathPlanner::setGoalStatePool(size_t statesPerGoal, size_t threads) {
+	goal_states_per_goal = statesPerGoal;
+	goal_state_threads = std::max(threads, (size_t) 1);
+}
+
+void ShellPathPlanner::precomputeGoalStates(const std::vector<ompl::base::GoalPtr> &goals,
+											const ompl::base::PlannerTerminationCondition &ptc) const {
+
+	std::vector<std::shared_ptr<DroneEndEffectorNearTarget>> pooled_goals;
+
+	for (const auto &goal: goals) {
+		if (auto pooled_goal = std::dynamic_pointer_cast<DroneEndEffectorNearTarget>(goal)) {
+			pooled_goals.push_back(pooled_goal);
+		}
+	}
+
+	// A fresh pool per query, since the states are only valid in the scene of these goals.
+	auto pool = std::make_shared<GoalStatePool>();
+	pool->fill(pooled_goals, goal_states_per_goal, goal_state_threads, ptc);
+
+	for (const auto &goal: pooled_goals) {
+		goal->setStatePool(pool);
+	}
+}
 
 MultiGoalPlanner::PlanResult ShellPathPlanner::plan(
 		const ompl::base::SpaceInformationPtr &si,
@@ -30,7 +77,20 @@ MultiGoalPlanner::PlanResult ShellPathPlanner::plan(
 
     OMPLSphereShellWrapper ompl_shell(shell, si);
 
-    auto approaches = planApproaches(si, goals, ompl_shell, ptc);
+	if (goal_states_per_goal > 0) {
+		precomputeGoalStates(goals, ptc);
+	}
+
+    auto approaches = approach_cache
+			? planApproachesCached(si, goals, planning_scene, ompl_shell, ptc)
+			: planApproaches(si, goals, ompl_shell, ptc);
+
+    if (experience_store) {
+		const size_t scene_hash = sceneHash(planning_scene);
+		for (const auto &approach: approaches) {
+			experience_store->add(scene_hash, approach.second);
+		}
+	}
 
     PlanResult result {{}};
 
@@ -38,7 +98,7 @@ MultiGoalPlanner::PlanResult ShellPathPlanner::plan(
         return result;
     }
 
-    auto ordering = computeApproachOrdering(start, goals, approaches, ompl_shell);
+    auto ordering = computeApproachOrdering(start, goals, approaches, ompl_shell, ptc);
 
     auto first_approach = planFirstApproach(start, approaches[ordering[0]].second);
 
@@ -49,6 +109,122 @@ MultiGoalPlanner::PlanResult ShellPathPlanner::plan(
     return assembleFullPath(si, goals, ompl_shell, approaches, ordering, result, *first_approach);
 }
 
+MultiGoalPlanner::PlanResult ShellPathPlanner::planStreaming(const ompl::base::SpaceInformationPtr &si,
+															  const ompl::base::State *start,
+															  const std::vector<ompl::base::GoalPtr> &goals,
+															  const AppleTreePlanningScene &planning_scene,
+															  ompl::base::PlannerTerminationCondition &ptc,
+															  const SegmentCallback &on_segment) {
+
+	auto shell = shell_builder(planning_scene);
+
+	OMPLSphereShellWrapper ompl_shell(shell, si);
+
+	PlanResult result{{}};
+
+	// Goals not visited yet, in the order we currently intend to visit them.
+	std::vector<size_t> remaining(goals.size());
+	std::iota(remaining.begin(), remaining.end(), 0);
+
+	// The goal the path so far ends at, together with its approach path.
+	std::optional<std::pair<size_t, ompl::geometric::PathGeometric>> previous;
+
+	auto reorder_remaining = [&]() {
+
+		// After the first ordering, `remaining` is the tail of the previous ordering, which makes a good warm start.
+		std::vector<size_t> current_order;
+		if (previous) {
+			current_order.resize(remaining.size());
+			std::iota(current_order.begin(), current_order.end(), 0);
+		}
+
+		auto suffix_ordering = tsp_open_end(
+				[&](size_t i) {
+					return previous
+						   ? ompl_shell.predict_path_length(goals[previous->first].get(), goals[remaining[i]].get())
+						   : ompl_shell.predict_path_length(start, goals[remaining[i]].get());
+				},
+				[&](size_t i, size_t j) {
+					return ompl_shell.predict_path_length(goals[remaining[i]].get(), goals[remaining[j]].get());
+				},
+				remaining.size(),
+				ptc,
+				tsp_options,
+				current_order
+		);
+
+		std::vector<size_t> reordered;
+		reordered.reserve(remaining.size());
+		for (size_t i: suffix_ordering) {
+			reordered.push_back(remaining[i]);
+		}
+		remaining = std::move(reordered);
+	};
+
+	try {
+
+		if (remaining.size() > 1) {
+			reorder_remaining();
+		}
+
+		while (!remaining.empty()) {
+
+			size_t goal_i = remaining.front();
+			remaining.erase(remaining.begin());
+
+			auto approach = planApproachForGoal(si, ompl_shell, goals[goal_i]);
+
+			if (approach && experience_store) {
+				experience_store->add(sceneHash(planning_scene), *approach);
+			}
+
+			std::optional<ompl::geometric::PathGeometric> segment;
+
+			if (approach && previous) {
+				ompl::geometric::PathGeometric goal_to_goal(si);
+				auto segment_path = retreat_move_probe(goals, ompl_shell, result, goal_to_goal, *previous, {goal_i, *approach});
+				segment = optimize(segment_path, std::make_shared<DronePathLengthObjective>(si), si);
+			} else if (approach) {
+				segment = planFirstApproach(start, *approach);
+			}
+
+			if (segment) {
+				result.segments.push_back({goal_i, *segment});
+				on_segment(result.segments.back());
+
+				previous = {goal_i, *approach};
+
+				// We're at a different goal now, so the best order for the rest may have changed.
+				if (remaining.size() > 1) {
+					reorder_remaining();
+				}
+			}
+
+			checkPtc(ptc);
+		}
+
+	} catch (PlanningTimeout &) {
+		// The segments emitted so far still form a valid prefix of the path, so we just return those.
+	}
+
+	return result;
+}
+
+std::future<MultiGoalPlanner::PlanResult> ShellPathPlanner::planStreamingAsync(const ompl::base::SpaceInformationPtr &si,
+																			   const ompl::base::State *start,
+																			   const std::vector<ompl::base::GoalPtr> &goals,
+																			   const AppleTreePlanningScene &planning_scene,
+																			   ompl::base::PlannerTerminationCondition &ptc,
+																			   SegmentCallback on_segment) {
+
+	auto start_copy = std::make_shared<ompl::base::ScopedState<>>(si);
+	si->copyState(start_copy->get(), start);
+
+	return std::async(std::launch::async, [this, si, start_copy, goals, &planning_scene, &ptc, on_segment = std::move(on_segment)]() {
+		return planStreaming(si, start_copy->get(), goals, planning_scene, ptc, on_segment);
+	});
+}
+
 MultiGoalPlanner::PlanResult ShellPathPlanner::assembleFullPath(
 		const ompl::base::SpaceInformationPtr &si,
 		const std::vector<ompl::base::GoalPtr> &goals,
@@ -78,7 +254,7 @@ MultiGoalPlanner::PlanResult ShellPathPlanner::assembleFullPath(
         auto end = std::chrono::steady_clock::now();
 
         result.segments.push_back({
-            approaches[ordering[0]].first,
+            approaches[ordering[i]].first,
             segment_path
         });
 
@@ -127,27 +303,96 @@ std::vector<size_t> ShellPathPlanner::computeApproachOrdering(
         const ompl::base::State *start,
         const std::vector<ompl::base::GoalPtr> &goals,
         const std::vector<std::pair<size_t, ompl::geometric::PathGeometric>> &approaches,
-        const OMPLSphereShellWrapper& shell) const {
-
-    return tsp_open_end(
-            [&](auto i) {
-                return shell.predict_path_length(start, goals[approaches[i].first].get());
-            },
-            [&](auto i, auto j) {
-                return shell.predict_path_length(
-                        goals[approaches[i].first].get(),
-                        goals[approaches[j].first].get()
-                );
-            },
-            approaches.size()
-    );
+        const OMPLSphereShellWrapper& shell,
+        const ompl::base::PlannerTerminationCondition &ptc) const {
+
+    if (approaches.empty()) {
+        return {};
+    }
+
+    std::vector<Eigen::Vector3d> targets;
+    for (const auto &approach : approaches) {
+        targets.push_back(goals[approach.first]->as<DroneEndEffectorNearTarget>()->getTarget());
+    }
+
+    Eigen::Vector3d start_position = endEffectorPosition(approaches.front().second.getSpaceInformation(), start);
+
+    // Approaches are identified by their target in the memo, since their indices change as goals are added or removed.
+    std::vector<size_t> item_hashes;
+    std::vector<size_t> warm_start;
+    TspMemo::Key memo_key;
+
+    if (tsp_options.memo) {
+        for (const auto &target : targets) {
+            item_hashes.push_back(TspMemo::hashPosition(target));
+        }
+
+        memo_key = {TspMemo::hashGoalSet(start_position, item_hashes), name(), tsp_options.memoKey()};
+
+        if (auto memoized = tsp_options.memo->lookup(memo_key, item_hashes)) {
+            return *memoized;
+        }
+
+        warm_start = tsp_options.memo->warmStart(memo_key.heuristic, item_hashes);
+    }
+
+    std::vector<const ompl::base::Goal *> approach_goals;
+    for (const auto &approach : approaches) {
+        approach_goals.push_back(goals[approach.first].get());
+    }
+
+    // Computes the forward kinematics of the start state once, rather than once per goal.
+    auto start_lengths = shell.predict_path_lengths(start, approach_goals);
+
+    auto from_start = [&](size_t i) {
+        return start_lengths[i];
+    };
+
+    auto between = [&](size_t i, size_t j) {
+        return shell.predict_path_length(approach_goals[i], approach_goals[j]);
+    };
+
+    try {
+        std::vector<size_t> ordering;
+
+        if (tsp_options.sparse_neighbours > 0) {
+            ordering = tsp_open_end_sparse(start_position, targets, from_start, between, ptc, tsp_options);
+        } else if (tsp_options.cluster_size > 0 && approaches.size() > tsp_options.cluster_size) {
+            ordering = tsp_open_end_hierarchical(from_start, between, approaches.size(), ptc, tsp_options);
+        } else {
+            // The full matrix is needed here, so compute it in batched rows.
+            ordering = tsp_open_end_rows(start_lengths, shell.predict_path_length_rows(approach_goals), ptc, tsp_options, warm_start);
+        }
+
+        if (tsp_options.memo) {
+            // A solve that the ptc cut short may be far from what an uninterrupted one would find.
+            tsp_options.memo->store(memo_key, item_hashes, ordering, !ptc());
+        }
+
+        return ordering;
+
+    } catch (PlanningTimeout &) {
+
+        // Out of time before any ordering was found; rather than throwing away the approaches
+        // planned so far, visit the goals in order of their distance from the start.
+        auto ordering = index_vector(approaches);
+        std::sort(ordering.begin(), ordering.end(), [&](size_t i, size_t j) {
+            return from_start(i) < from_start(j);
+        });
+        return ordering;
+    }
 }
 
 std::vector<std::pair<size_t, ompl::geometric::PathGeometric>>
 ShellPathPlanner::planApproaches(const ompl::base::SpaceInformationPtr &si,
 								 const std::vector<ompl::base::GoalPtr> &goals,
 								 const OMPLSphereShellWrapper &ompl_shell,
-								 ompl::base::PlannerTerminationCondition &ptc) const {
+								 ompl::base::PlannerTerminationCondition &ptc,
+								 const ApproachCallback &on_approach) const {
+
+	if (use_shared_roadmap) {
+		return planApproachesSharedRoadmap(si, goals, ompl_shell, ptc, on_approach);
+	}
 
     std::vector<std::pair<size_t, ompl::geometric::PathGeometric>> approaches;
 
@@ -158,6 +403,10 @@ ShellPathPlanner::planApproaches(const ompl::base::SpaceInformationPtr &si,
                     goal_i,
                     *approach
             );
+
+			if (on_approach) {
+				on_approach(goal_i, *approach);
+			}
         }
 
 		checkPtc(ptc);
@@ -177,28 +426,149 @@ std::optional<ompl::geometric::PathGeometric> ShellPathPlanner::planApproachForG
 
     auto approach_path = methods->state_to_goal(shell_state.get(), goal);
 
-    if (apply_shellstate_optimization && approach_path) {
-        *approach_path = optimizeExit(
-                goal.get(),
-                *approach_path,
-                std::make_shared<DronePathLengthObjective>(si),
-                ompl_shell,
-                si
-        );
+    if (approach_path) {
+        *approach_path = postprocessApproach(si, ompl_shell, goal, *approach_path);
     }
 
     return approach_path;
 }
 
+std::vector<std::pair<size_t, ompl::geometric::PathGeometric>>
+ShellPathPlanner::planApproachesCached(const ompl::base::SpaceInformationPtr &si,
+									   const std::vector<ompl::base::GoalPtr> &goals,
+									   const AppleTreePlanningScene &planning_scene,
+									   const OMPLSphereShellWrapper &ompl_shell,
+									   ompl::base::PlannerTerminationCondition &ptc) const {
+
+	const size_t scene_hash = sceneHash(planning_scene);
+
+	Json::StreamWriterBuilder writer;
+	writer["indentation"] = "";
+	const std::string planner_parameters = Json::writeString(writer, approachParameters());
+
+	std::vector<std::pair<size_t, ompl::geometric::PathGeometric>> approaches;
+
+	// Goals that are not in the cache, with their cache key if they have one (apples not in the scene don't).
+	std::vector<ompl::base::GoalPtr> missing_goals;
+	std::vector<size_t> missing_goal_ids;
+	std::vector<std::optional<ApproachPathCache::Key>> missing_keys;
+
+	for (const auto &[goal_i, goal]: goals | ranges::views::enumerate) {
+
+		auto apple_index = appleIndexAt(planning_scene, goal->as<DroneEndEffectorNearTarget>()->getTarget());
+
+		std::optional<ApproachPathCache::Key> key;
+		if (apple_index) {
+			key = ApproachPathCache::Key{scene_hash, *apple_index, planner_parameters};
+
+			if (auto cached = approach_cache->lookup(*key, si)) {
+				approaches.emplace_back(goal_i, *cached);
+				continue;
+			}
+		}
+
+		missing_goals.push_back(goal);
+		missing_goal_ids.push_back(goal_i);
+		missing_keys.push_back(key);
+	}
+
+	// Store every approach as soon as it is planned, such that they are not lost if planning times out.
+	auto store = [&](size_t missing_i, const ompl::geometric::PathGeometric &approach) {
+		if (missing_keys[missing_i]) {
+			approach_cache->store(*missing_keys[missing_i], approach);
+		}
+	};
+
+	for (const auto &[missing_i, approach]: planApproaches(si, missing_goals, ompl_shell, ptc, store)) {
+		approaches.emplace_back(missing_goal_ids[missing_i], approach);
+	}
+
+	// Keep the same order as planApproaches would.
+	std::sort(approaches.begin(), approaches.end(), [](const auto &a, const auto &b) {
+		return a.first < b.first;
+	});
+
+	return approaches;
+}
+
+std::vector<std::pair<size_t, ompl::geometric::PathGeometric>>
+ShellPathPlanner::planApproachesSharedRoadmap(const ompl::base::SpaceInformationPtr &si,
+											  const std::vector<ompl::base::GoalPtr> &goals,
+											  const OMPLSphereShellWrapper &ompl_shell,
+											  ompl::base::PlannerTerminationCondition &ptc,
+											  const ApproachCallback &on_approach) const {
+
+	// The shell states need to outlive the batch query.
+	std::vector<ompl::base::ScopedState<>> shell_states;
+	shell_states.reserve(goals.size());
+
+	std::vector<SingleGoalPlannerMethods::GoalQuery> queries;
+	queries.reserve(goals.size());
+
+	for (const auto &goal: goals) {
+		shell_states.emplace_back(si);
+		ompl_shell.state_on_shell(goal.get(), shell_states.back().get());
+		queries.push_back({shell_states.back().get(), goal});
+	}
+
+	std::vector<std::pair<size_t, ompl::geometric::PathGeometric>> approaches;
+
+	// Collected as the queries complete, since the batch throws on timeout.
+	methods->state_to_goal_batch(queries, ptc, [&](size_t goal_i, const SingleGoalPlannerMethods::GoalQueryResult &result) {
+		if (result.path) {
+			approaches.emplace_back(goal_i, postprocessApproach(si, ompl_shell, goals[goal_i], *result.path));
+
+			if (on_approach) {
+				on_approach(goal_i, approaches.back().second);
+			}
+		}
+	});
+
+	return approaches;
+}
+
+ompl::geometric::PathGeometric ShellPathPlanner::postprocessApproach(const ompl::base::SpaceInformationPtr &si,
+																	 const OMPLSphereShellWrapper &ompl_shell,
+																	 const ompl::base::GoalPtr &goal,
+																	 const ompl::geometric::PathGeometric &approach_path) const {
+
+	if (!apply_shellstate_optimization) {
+		return approach_path;
+	}
+
+	return optimizeExit(
+			goal.get(),
+			approach_path,
+			std::make_shared<DronePathLengthObjective>(si),
+			ompl_shell,
+			si
+	);
+}
+
 Json::Value ShellPathPlanner::parameters() const {
     Json::Value result;
 
     result["apply_shellstate_optimization"] = apply_shellstate_optimization;
     result["ptp"] = methods->parameters();
+	result["use_shared_roadmap"] = use_shared_roadmap;
+	result["approach_cache"] = approach_cache != nullptr;
+	result["tsp"] = tsp_options.parameters();
+	result["experience"] = experience_store != nullptr;
+	result["goal_states_per_goal"] = (Json::UInt64) goal_states_per_goal;
 
     return result;
 }
 
+Json::Value ShellPathPlanner::approachParameters() const {
+	Json::Value result;
+
+	result["apply_shellstate_optimization"] = apply_shellstate_optimization;
+	result["ptp"] = methods->parameters();
+	result["use_shared_roadmap"] = use_shared_roadmap;
+
+	return result;
+}
+
 std::string ShellPathPlanner::name() const {
     return "ShellPathPlanner";
 }
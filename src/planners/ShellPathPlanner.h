@@ -2,11 +2,16 @@
 #ifndef NEW_PLANNERS_SHELLPATHPLANNER_H
 #define NEW_PLANNERS_SHELLPATHPLANNER_H
 
+#include <future>
 #include <range/v3/view/enumerate.hpp>
 #include "MultiGoalPlanner.h"
 #include "../SphereShell.h"
 #include "../DistanceHeuristics.h"
 #include "../planning_scene_diff_message.h"
+#include "../ApproachPathCache.h"
+#include "../ExperienceStore.h"
+#include "../GoalStatePool.h"
+#include "../traveling_salesman.h"
 
 class ShellPathPlanner : public MultiGoalPlanner {
 
@@ -18,16 +23,93 @@ class ShellPathPlanner : public MultiGoalPlanner {
 
     bool apply_shellstate_optimization;
 
+	/// Whether to plan all approaches against one shared roadmap (see SingleGoalPlannerMethods::state_to_goal_batch),
+	/// rather than with a fresh planner per goal.
+	bool use_shared_roadmap;
+
+	/// Optional cache of approach paths, possibly shared with other planner instances. Null to disable caching.
+	std::shared_ptr<ApproachPathCache> approach_cache;
+
+	/// How to solve the ordering problem.
+	TspOptions tsp_options;
+
+	/// Optional store that the approach paths are added to, for experience-based sampling (see Experience). Null to disable.
+	std::shared_ptr<ExperienceStore> experience_store;
+
+	/// Number of valid goal states to precompute per goal before planning approaches (see GoalStatePool); 0 to disable.
+	size_t goal_states_per_goal = 0;
+
+	/// Number of threads to precompute them on.
+	size_t goal_state_threads = 1;
+
 public:
     ShellPathPlanner(bool applyShellstateOptimization,
 					 std::shared_ptr<SingleGoalPlannerMethods> methods,
-					 MakeShellFn& shellBuilder);
+					 MakeShellFn& shellBuilder,
+					 bool useSharedRoadmap = false,
+					 std::shared_ptr<ApproachPathCache> approachCache = nullptr,
+					 TspOptions tspOptions = {});
+
+	/**
+	 * Add every approach path that is planned from now on to the given store, under the hash of the scene.
+	 * Pass null to stop recording.
+	 */
+	void setExperienceStore(std::shared_ptr<ExperienceStore> experienceStore);
+
+	/**
+	 * In plan(), before planning approaches, fill a GoalStatePool with the given number of valid states per goal
+	 * (on the given number of threads), and have the goals draw their samples from it. The goals keep the pool
+	 * afterwards, and sample live once it runs out. Pass 0 states to sample goals live throughout.
+	 */
+	void setGoalStatePool(size_t statesPerGoal, size_t threads);
+
+	/**
+	 * Precompute goal states for the goals that are DroneEndEffectorNearTarget (see setGoalStatePool),
+	 * until done or the ptc triggers, and attach the pool to them.
+	 */
+	void precomputeGoalStates(const std::vector<ompl::base::GoalPtr> &goals,
+							  const ompl::base::PlannerTerminationCondition &ptc) const;
 
     PlanResult plan(const ompl::base::SpaceInformationPtr &si, const ompl::base::State *start,
                     const std::vector<ompl::base::GoalPtr> &goals,
                     const AppleTreePlanningScene &planning_scene,
 					ompl::base::PlannerTerminationCondition& ptc) override;
 
+	/// Called with every segment of the path, in order, as soon as that segment is available.
+	typedef std::function<void(const PathSegment &)> SegmentCallback;
+
+	/**
+	 * Anytime variant of plan(), for when the robot should start moving as soon as possible.
+	 *
+	 * Goals are ordered by predicted shell path length up-front, after which approaches are planned one
+	 * at a time in that order. Every segment is passed to on_segment as soon as it is complete, so the first
+	 * segment is available after planning just one approach. After each segment, the remaining goals are
+	 * re-ordered starting from the goal just reached.
+	 *
+	 * On timeout, the segments emitted so far are returned rather than throwing.
+	 *
+	 * @return The same segments as were passed to on_segment.
+	 */
+	PlanResult planStreaming(const ompl::base::SpaceInformationPtr &si,
+							 const ompl::base::State *start,
+							 const std::vector<ompl::base::GoalPtr> &goals,
+							 const AppleTreePlanningScene &planning_scene,
+							 ompl::base::PlannerTerminationCondition &ptc,
+							 const SegmentCallback &on_segment);
+
+	/**
+	 * Run planStreaming on a separate thread; on_segment is called from that thread.
+	 *
+	 * The start state and goals are copied, but this planner, the planning scene and the ptc must stay alive
+	 * until the future is ready.
+	 */
+	std::future<PlanResult> planStreamingAsync(const ompl::base::SpaceInformationPtr &si,
+											   const ompl::base::State *start,
+											   const std::vector<ompl::base::GoalPtr> &goals,
+											   const AppleTreePlanningScene &planning_scene,
+											   ompl::base::PlannerTerminationCondition &ptc,
+											   SegmentCallback on_segment);
+
     PlanResult assembleFullPath(
             const ompl::base::SpaceInformationPtr &si,
             const std::vector<ompl::base::GoalPtr> &goals,
@@ -49,23 +131,75 @@ public:
             const ompl::base::State *start,
             ompl::geometric::PathGeometric &approach_path);
 
+    /**
+     * Order the approaches with the TSP solver in tsp_options. The solver stops when the ptc triggers;
+     * if that happens before any ordering is found, the goals are ordered by their predicted distance from the start.
+     */
     std::vector<size_t> computeApproachOrdering(
             const ompl::base::State *start,
             const std::vector<ompl::base::GoalPtr> &goals,
             const std::vector<std::pair<size_t, ompl::geometric::PathGeometric>> &approaches,
-            const OMPLSphereShellWrapper& distance_heuristics) const;
-
+            const OMPLSphereShellWrapper& distance_heuristics,
+            const ompl::base::PlannerTerminationCondition &ptc) const;
+
+	/// Called with the index of the goal and its (post-processed) approach path, as soon as that path is planned.
+	typedef std::function<void(size_t, const ompl::geometric::PathGeometric &)> ApproachCallback;
+
+	/**
+	 * Plan an approach path for every goal; goals without one are left out.
+	 *
+	 * @param on_approach 	Optional; called for every approach as soon as it is planned, such that
+	 * 						the approaches planned before a PlanningTimeout are not lost.
+	 */
     std::vector<std::pair<size_t, ompl::geometric::PathGeometric>>
 	planApproaches(const ompl::base::SpaceInformationPtr &si,
 				   const std::vector<ompl::base::GoalPtr> &goals,
 				   const OMPLSphereShellWrapper &ompl_shell,
-				   ompl::base::PlannerTerminationCondition &ptc) const;
+				   ompl::base::PlannerTerminationCondition &ptc,
+				   const ApproachCallback &on_approach = nullptr) const;
 
     std::optional<ompl::geometric::PathGeometric> planApproachForGoal(
             const ompl::base::SpaceInformationPtr &si,
             const OMPLSphereShellWrapper &ompl_shell,
             const ompl::base::GoalPtr &goal) const;
 
+	/**
+	 * Same as planApproaches, but looks up the approaches in the approach_cache first,
+	 * and only plans (and then caches) the ones that are missing.
+	 */
+	std::vector<std::pair<size_t, ompl::geometric::PathGeometric>>
+	planApproachesCached(const ompl::base::SpaceInformationPtr &si,
+						 const std::vector<ompl::base::GoalPtr> &goals,
+						 const AppleTreePlanningScene &planning_scene,
+						 const OMPLSphereShellWrapper &ompl_shell,
+						 ompl::base::PlannerTerminationCondition &ptc) const;
+
+	/**
+	 * Plan the approaches for all goals in one batch, against a shared roadmap.
+	 * Same output as planApproaches.
+	 */
+	std::vector<std::pair<size_t, ompl::geometric::PathGeometric>>
+	planApproachesSharedRoadmap(const ompl::base::SpaceInformationPtr &si,
+								const std::vector<ompl::base::GoalPtr> &goals,
+								const OMPLSphereShellWrapper &ompl_shell,
+								ompl::base::PlannerTerminationCondition &ptc,
+								const ApproachCallback &on_approach = nullptr) const;
+
+	/**
+	 * The parameters that shape approach paths, as part of the approach_cache key; unlike parameters(),
+	 * this leaves out everything that only affects the ordering or the rest of the path.
+	 */
+	[[nodiscard]] Json::Value approachParameters() const;
+
+	/**
+	 * Apply the shell-state optimization to an approach path, if enabled.
+	 */
+	[[nodiscard]] ompl::geometric::PathGeometric postprocessApproach(
+			const ompl::base::SpaceInformationPtr &si,
+			const OMPLSphereShellWrapper &ompl_shell,
+			const ompl::base::GoalPtr &goal,
+			const ompl::geometric::PathGeometric &approach_path) const;
+
     Json::Value parameters() const override;
 
     std::string name() const override;
@@ -9,6 +9,8 @@
 #include "general_utilities.h"
 #include "Seb.h"
 
+#include <boost/functional/hash.hpp>
+
 void createTrunkInPlanningSceneMessage(const std::vector<DetachedTreeNode> &tree_flattened,
                                        moveit_msgs::msg::PlanningScene &planning_scene) {
     moveit_msgs::msg::CollisionObject collision_object;
@@ -260,3 +262,25 @@ AppleTreePlanningScene createMeshBasedAppleTreePlanningSceneMessage(const std::s
     return {planning_scene_message, apples_from_connected_components(apples)};
 }
 
+size_t sceneHash(const AppleTreePlanningScene &scene) {
+
+	// boost::hash is deterministic, unlike std::hash which is allowed to be salted.
+	size_t seed = 0;
+	boost::hash_combine(seed, scene.scene_msg.name);
+
+	for (const auto &apple: scene.apples) {
+		boost::hash_combine(seed, apple.center.x());
+		boost::hash_combine(seed, apple.center.y());
+		boost::hash_combine(seed, apple.center.z());
+	}
+
+	return seed;
+}
+
+std::optional<size_t> appleIndexAt(const AppleTreePlanningScene &scene, const Eigen::Vector3d &center) {
+	auto fnd = std::find_if(scene.apples.begin(), scene.apples.end(), [&](const Apple &apple) {
+		return apple.center == center;
+	});
+	if (fnd == scene.apples.end()) return {};
+	else return {fnd - scene.apples.begin()};
+}
@@ -3,6 +3,7 @@
 #define NEW_PLANNERS_PLANNING_SCENE_DIFF_MESSAGE_H
 
 #include <moveit/planning_scene/planning_scene.h>
+#include <optional>
 
 #include "procedural_tree_generation.h"
 
@@ -26,6 +27,17 @@ const double TRANSLATION_BOUND = 10.0;
 
 AppleTreePlanningScene createMeshBasedAppleTreePlanningSceneMessage(const std::string &model_name);
 
+/**
+ * A hash identifying a scene by its name and apple positions; stable across runs of the program,
+ * such that it can be used as a key in data persisted to disk.
+ */
+size_t sceneHash(const AppleTreePlanningScene &scene);
+
+/**
+ * Look up the index in `scene.apples` of the apple centered exactly on the given point, if any.
+ */
+std::optional<size_t> appleIndexAt(const AppleTreePlanningScene &scene, const Eigen::Vector3d &center);
+
 
 
 #endif //NEW_PLANNERS_PLANNING_SCENE_DIFF_MESSAGE_H
@@ -5,6 +5,7 @@
 #include "DistanceHeuristics.h"
 #include "planners/ShellPathPlanner.h"
 #include "planners/MultigoalPrmStar.h"
+#include "thread_rng.h"
 #include <range/v3/all.hpp>
 #include <fstream>
 #include <filesystem>
@@ -215,11 +216,14 @@ void tryReloadAndValidateCachedStats(const string &results_path,
 	}
 }
 
-/// Run a single planner-problem pair.
-Json::Value run_task(const moveit::core::RobotModelConstPtr &drone, const Run &run) {
+/// Run a single planner-problem pair; `task_index` is its index in the (deterministic) list of runs.
+Json::Value run_task(const moveit::core::RobotModelConstPtr &drone, const Run &run, size_t task_index) {
 	const auto &[planner_allocator, start_state_pair] = run;
 	const auto &[run_i, start_state, apples, scene] = start_state_pair;
 
+	// Whichever worker picks up the task, the samplers that use the thread-local generators draw the same numbers.
+	seed_thread_rng(task_index);
+
 	// Initialize the OMPL stuff. We do this separately for each run to prevent state cross-contamination.
 
 	// *Somewhere* in the state space is something that isn't thread-safe despite const-ness.
@@ -258,6 +262,7 @@ Json::Value run_task(const moveit::core::RobotModelConstPtr &drone, const Run &r
 	auto plan_result = toJson(result);
 	plan_result["run_time"] = run_time;
 	plan_result["start_state"] = (int) run_i;
+	plan_result["rng_seed"] = (Json::UInt64) task_index;
 	plan_result["scene_name"] = scene->scene_msg.name;
 	plan_result["napples"] = apples.size();
 	plan_result["planner_params"] = planner->parameters();
@@ -371,7 +376,7 @@ void run_planner_experiment(const std::vector<NewMultiGoalPlannerAllocatorFn> &a
 				std::cout << "Starting task " << *thread_current_task << " of " << runs.size() << std::endl;
 
 				// Run the run and gather stats about it.
-				Json::Value plan_result = run_task(drone, runs[*thread_current_task]);
+				Json::Value plan_result = run_task(drone, runs[*thread_current_task], *thread_current_task);
 
 				cout << "Completed run " << *thread_current_task << " of " << runs.size() << endl;
 
@@ -404,7 +409,9 @@ std::shared_ptr<SphereShell> buildSphereShell(const AppleTreePlanningScene& scen
 }
 
 /// Generate a list of ShellPathPlanner allocators to be run during an experiment.
-std::vector<NewMultiGoalPlannerAllocatorFn> make_shellpath_allocators() {
+std::vector<NewMultiGoalPlannerAllocatorFn> make_shellpath_allocators(
+		const std::shared_ptr<ApproachPathCache> &approach_cache,
+		const std::shared_ptr<ExperienceStore> &experience) {
 
 	// We'll be taking a cartesian product of these.
 	// Due to C++ ownership stupidity, it's best to keep plain old data here only.
@@ -417,8 +424,14 @@ std::vector<NewMultiGoalPlannerAllocatorFn> make_shellpath_allocators() {
 	bool useImprovisedInformedSampler[] = {true};
 	bool tryLuckyShots[] = {true};
 	bool useCostConvergence[] = {true};
+	bool useNarrowPassageSampler[] = {false};
+	bool useEndEffectorCorridor[] = {false};
+	size_t goalStatesPerGoal[] = {0};
 	double ptp_time_seconds[] = {0.4, 0.5, 1.0};
 
+	// Threads per run to precompute goal states on, if enabled; the runs themselves already run in parallel.
+	const size_t GOAL_STATE_THREADS = 2;
+
 	// We explicitly use a function pointer here so we don't get burnt by this containing a reference to some local variable.
 	ompl::base::PlannerPtr(*planner_allocators[])(const ompl::base::SpaceInformationPtr&) = { &allocPRM };
 
@@ -428,11 +441,14 @@ std::vector<NewMultiGoalPlannerAllocatorFn> make_shellpath_allocators() {
 											planner_allocators,
 											useImprovisedInformedSampler,
 											tryLuckyShots,
-											useCostConvergence) |
-		   ranges::views::transform([](const auto tuple) -> NewMultiGoalPlannerAllocatorFn {
+											useCostConvergence,
+											useNarrowPassageSampler,
+											useEndEffectorCorridor,
+											goalStatesPerGoal) |
+		   ranges::views::transform([approach_cache, experience](const auto tuple) -> NewMultiGoalPlannerAllocatorFn {
 
 			   // Unpack the tuple.
-			   auto [shellOptimize, ptp_budget, allocator, improvised_sampler, tryLucky, costConvergence] = tuple;
+			   auto [shellOptimize, ptp_budget, allocator, improvised_sampler, tryLucky, costConvergence, narrowPassage, corridor, goalStates] = tuple;
 
 			   // Explicitly capture each by value to prevent any references from going out of scope.
 			   return [shellOptimize = shellOptimize,
@@ -440,7 +456,12 @@ std::vector<NewMultiGoalPlannerAllocatorFn> make_shellpath_allocators() {
 					   allocator = allocator,
 					   improvised_sampler = improvised_sampler,
 					   tryLucky = tryLucky,
-					   costConvergence = costConvergence](
+					   costConvergence = costConvergence,
+					   narrowPassage = narrowPassage,
+					   corridor = corridor,
+					   goalStates = goalStates,
+					   approach_cache = approach_cache,
+					   experience = experience](
 					   const AppleTreePlanningScene &scene_info,
 					   const ompl::base::SpaceInformationPtr &si) {
 
@@ -452,7 +473,37 @@ std::vector<NewMultiGoalPlannerAllocatorFn> make_shellpath_allocators() {
 																		 tryLucky,
 																		 costConvergence);
 
-				   return std::make_shared<ShellPathPlanner>(shellOptimize, ptp, buildSphereShell);
+				   std::shared_ptr<SamplerWrapper> sampler;
+
+				   if (narrowPassage) {
+					   sampler = std::make_shared<NarrowPassage>(si, compute_enclosing_sphere(scene_info.scene_msg, 0.1));
+				   }
+
+				   if (experience) {
+					   sampler = std::make_shared<Experience>(si->getStateSpace().get(), experience, sceneHash(scene_info), sampler);
+				   }
+
+				   if (sampler) {
+					   ptp->setSampler(sampler);
+				   }
+
+				   if (corridor) {
+					   auto occupancy = std::make_shared<VoxelOccupancy>(
+							   VoxelOccupancy::fromSceneMessage(scene_info.scene_msg, 0.05, 0.1));
+					   ptp->setCorridorPlanner(std::make_shared<EndEffectorCorridorPlanner>(si, occupancy));
+				   }
+
+				   auto planner = std::make_shared<ShellPathPlanner>(shellOptimize, ptp, buildSphereShell, false, approach_cache);
+
+				   if (experience) {
+					   planner->setExperienceStore(experience);
+				   }
+
+				   if (goalStates > 0) {
+					   planner->setGoalStatePool(goalStates, GOAL_STATE_THREADS);
+				   }
+
+				   return planner;
 			   };
 		   }) | ranges::to_vector; //  We return a vector to, again, prevent returning references to local variables.
 }
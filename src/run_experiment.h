@@ -9,6 +9,8 @@
 #include "planners/MultiGoalPlanner.h"
 #include "planning_scene_diff_message.h"
 #include "ompl_custom.h"
+#include "ApproachPathCache.h"
+#include "ExperienceStore.h"
 
 typedef std::function<std::shared_ptr<MultiGoalPlanner>(
         const AppleTreePlanningScene& scene_info,
@@ -23,7 +25,16 @@ run_planner_experiment(const std::vector<NewMultiGoalPlannerAllocatorFn> &alloca
                        unsigned int nworkers);
 
 
-std::vector<NewMultiGoalPlannerAllocatorFn> make_shellpath_allocators();
+/**
+ * Generate the ShellPathPlanner allocators to be run during an experiment.
+ *
+ * @param approach_cache 	If non-null, the planners will share this cache of approach paths between runs.
+ * @param experience 		If non-null, the planners add their approach paths to this store, and sample near
+ * 							the paths stored earlier for the same scene.
+ */
+std::vector<NewMultiGoalPlannerAllocatorFn> make_shellpath_allocators(
+		const std::shared_ptr<ApproachPathCache> &approach_cache = nullptr,
+		const std::shared_ptr<ExperienceStore> &experience = nullptr);
 
 std::vector<NewMultiGoalPlannerAllocatorFn> make_tsp_over_prm_allocators();
 
@@ -0,0 +1,309 @@
+
+#include "sparse_tsp.h"
+
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <ompl/datastructures/NearestNeighborsGNAT.h>
+
+namespace {
+
+	/// Stand-in for "no next node", at the open end of the tour. Distances to it are zero.
+	constexpr size_t NO_NODE = std::numeric_limits<size_t>::max();
+
+	/// Moves must improve the tour by at least this much, to avoid cycling on rounding errors.
+	constexpr double IMPROVEMENT_EPSILON = 1.0e-9;
+
+	/// How many moves to consider between checks of the ptc.
+	constexpr size_t PTC_CHECK_INTERVAL = 256;
+
+	/// A GNAT over node indices, using the Euclidean distance between node positions.
+	ompl::NearestNeighborsGNAT<size_t> position_gnat(const SparseOpenTsp &problem) {
+
+		ompl::NearestNeighborsGNAT<size_t> gnat;
+
+		gnat.setDistanceFunction([&problem](const size_t &a, const size_t &b) {
+			return (problem.positions[a] - problem.positions[b]).norm();
+		});
+
+		return gnat;
+	}
+
+	/// Greedily go to the nearest (by position) unvisited node, starting at the start.
+	std::vector<size_t> nearest_neighbour_tour(const SparseOpenTsp &problem) {
+
+		auto gnat = position_gnat(problem);
+
+		std::vector<size_t> nodes(problem.n);
+		std::iota(nodes.begin(), nodes.end(), 0);
+		gnat.add(nodes);
+
+		std::vector<size_t> tour{problem.start()};
+		tour.reserve(problem.n + 1);
+
+		while (gnat.size() > 0) {
+			size_t nearest = gnat.nearest(tour.back());
+			gnat.remove(nearest);
+			tour.push_back(nearest);
+		}
+
+		return tour;
+	}
+
+	/**
+	 * Local search moves, restricted to the candidate graph. The tour includes the start node at position 0,
+	 * which is never moved.
+	 */
+	class SparseTourSearch {
+
+		const SparseOpenTsp &problem;
+
+		/// Position of every node (including the start) in the tour.
+		std::vector<size_t> position;
+
+		[[nodiscard]] double d(size_t a, size_t b) const {
+			return b == NO_NODE ? 0.0 : problem.distance(a, b);
+		}
+
+		[[nodiscard]] size_t after(size_t tour_position) const {
+			return tour_position + 1 < tour.size() ? tour[tour_position + 1] : NO_NODE;
+		}
+
+		void updatePositions(size_t from, size_t to) {
+			for (size_t k = from; k <= to; ++k) {
+				position[tour[k]] = k;
+			}
+		}
+
+		void reverse(size_t from, size_t to) {
+			std::reverse(tour.begin() + (long) from, tour.begin() + (long) to + 1);
+			updatePositions(from, to);
+		}
+
+	public:
+		std::vector<size_t> tour;
+
+		SparseTourSearch(const SparseOpenTsp &problem, std::vector<size_t> initial_tour)
+				: problem(problem), position(problem.n + 1), tour(std::move(initial_tour)) {
+			updatePositions(0, tour.size() - 1);
+		}
+
+		/**
+		 * For every tour edge (a,b), try to replace it by an edge from a to one of its candidates c,
+		 * reversing the part of the tour in between.
+		 */
+		bool twoOpt(const ompl::base::PlannerTerminationCondition &ptc) {
+
+			bool improved = false;
+
+			for (size_t i = 0; i + 1 < tour.size(); ++i) {
+
+				if (i % PTC_CHECK_INTERVAL == 0 && ptc()) {
+					break;
+				}
+
+				size_t a = tour[i], b = tour[i + 1];
+				double d_ab = d(a, b);
+
+				for (size_t c: problem.candidates[a]) {
+
+					double d_ac = d(a, c);
+
+					// A 2-opt move that adds (a,c) can only gain anything if (a,c) is shorter than the (a,b) it replaces.
+					if (d_ac >= d_ab) {
+						continue;
+					}
+
+					size_t j = position[c];
+
+					if (j > i + 1) {
+						// Reversing tour[i+1..=j] replaces (a,b) and (c,e) by (a,c) and (b,e).
+						size_t e = after(j);
+						if (d_ac + d(b, e) - d_ab - d(c, e) < -IMPROVEMENT_EPSILON) {
+							reverse(i + 1, j);
+							improved = true;
+							break;
+						}
+					} else if (j + 1 < i) {
+						// Reversing tour[j+1..=i] replaces (c,f) and (a,b) by (c,a) and (f,b).
+						size_t f = tour[j + 1];
+						if (d_ac + d(f, b) - d(c, f) - d_ab < -IMPROVEMENT_EPSILON) {
+							reverse(j + 1, i);
+							improved = true;
+							break;
+						}
+					}
+				}
+			}
+
+			return improved;
+		}
+
+		/**
+		 * Move segments of up to three nodes (possibly reversed) next to a candidate of either of their endpoints.
+		 */
+		bool orOpt(const ompl::base::PlannerTerminationCondition &ptc) {
+
+			bool improved = false;
+			size_t moves_considered = 0;
+
+			for (size_t length = 1; length <= 3; ++length) {
+				for (size_t i = 1; i + length <= tour.size(); ++i) {
+
+					if (++moves_considered % PTC_CHECK_INTERVAL == 0 && ptc()) {
+						return improved;
+					}
+
+					size_t first = tour[i], last = tour[i + length - 1];
+					size_t prev = tour[i - 1], next = after(i + length - 1);
+
+					double removal_gain = d(prev, first) + d(last, next) - d(prev, next);
+
+					if (removal_gain <= IMPROVEMENT_EPSILON) {
+						continue;
+					}
+
+					double best_delta = -IMPROVEMENT_EPSILON;
+					size_t best_x = NO_NODE;
+					bool best_reversed = false;
+
+					for (size_t endpoint: {first, last}) {
+						for (size_t c: problem.candidates[endpoint]) {
+
+							size_t q = position[c];
+
+							if (q + 1 >= i && q <= i + length - 1) {
+								continue;
+							}
+
+							// Insert between x and y: either right after c, or right before it.
+							for (bool after_c: {true, false}) {
+
+								size_t x = after_c ? c : tour[q - 1];
+								size_t y = after_c ? after(q) : c;
+
+								if (x == last) {
+									continue;
+								}
+
+								double base = d(x, y);
+								double forward = d(x, first) + d(last, y) - base - removal_gain;
+								double reversed = d(x, last) + d(first, y) - base - removal_gain;
+
+								if (forward < best_delta) {
+									best_delta = forward;
+									best_x = x;
+									best_reversed = false;
+								}
+								if (reversed < best_delta) {
+									best_delta = reversed;
+									best_x = x;
+									best_reversed = true;
+								}
+							}
+						}
+					}
+
+					if (best_x != NO_NODE) {
+
+						std::vector<size_t> segment(tour.begin() + (long) i, tour.begin() + (long) (i + length));
+						if (best_reversed) {
+							std::reverse(segment.begin(), segment.end());
+						}
+
+						tour.erase(tour.begin() + (long) i, tour.begin() + (long) (i + length));
+
+						size_t x_position = position[best_x] > i ? position[best_x] - length : position[best_x];
+						tour.insert(tour.begin() + (long) x_position + 1, segment.begin(), segment.end());
+
+						updatePositions(0, tour.size() - 1);
+
+						improved = true;
+					}
+				}
+			}
+
+			return improved;
+		}
+	};
+}
+
+SparseOpenTsp::SparseOpenTsp(const Eigen::Vector3d &start_position,
+							 const std::vector<Eigen::Vector3d> &positions,
+							 const std::function<double(size_t)> &from_start,
+							 std::function<double(size_t, size_t)> between,
+							 size_t k)
+		: between(std::move(between)), n(positions.size()), positions(positions) {
+
+	this->positions.push_back(start_position);
+
+	this->from_start.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		this->from_start.push_back(from_start(i));
+	}
+
+	auto gnat = position_gnat(*this);
+
+	std::vector<size_t> nodes(n);
+	std::iota(nodes.begin(), nodes.end(), 0);
+	gnat.add(nodes);
+
+	candidates.resize(n + 1);
+
+	for (size_t i = 0; i <= n; ++i) {
+
+		// The node itself is in the GNAT (except for the start), so ask for one extra.
+		std::vector<size_t> neighbours;
+		gnat.nearestK(i, k + 1, neighbours);
+
+		for (size_t neighbour: neighbours) {
+			if (neighbour != i && candidates[i].size() < k) {
+				candidates[i].push_back(neighbour);
+			}
+		}
+	}
+}
+
+double SparseOpenTsp::distance(size_t i, size_t j) const {
+
+	if (i == j) {
+		return 0.0;
+	}
+	if (i == start()) {
+		return from_start[j];
+	}
+	if (j == start()) {
+		return from_start[i];
+	}
+
+	size_t key = std::min(i, j) * (n + 1) + std::max(i, j);
+
+	auto it = memo.find(key);
+	if (it == memo.end()) {
+		it = memo.emplace(key, between(i, j)).first;
+	}
+
+	return it->second;
+}
+
+std::vector<size_t> solve_sparse_open_tsp(const SparseOpenTsp &problem, const ompl::base::PlannerTerminationCondition &ptc) {
+
+	if (problem.n == 0) {
+		return {};
+	}
+
+	SparseTourSearch search(problem, nearest_neighbour_tour(problem));
+
+	while (!ptc()) {
+
+		bool improved = search.twoOpt(ptc);
+		improved |= search.orOpt(ptc);
+
+		if (!improved) {
+			break;
+		}
+	}
+
+	// Drop the start node.
+	return {search.tour.begin() + 1, search.tour.end()};
+}
@@ -0,0 +1,73 @@
+#ifndef NEW_PLANNERS_SPARSE_TSP_H
+#define NEW_PLANNERS_SPARSE_TSP_H
+
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <Eigen/Core>
+#include <ompl/base/PlannerTerminationCondition.h>
+
+/**
+ * An open-ended TSP in which every node is only connected to its k nearest neighbours (by position),
+ * for goal sets that are too large for a complete distance matrix.
+ *
+ * The (possibly expensive) exact distance is only evaluated on demand, for edges of the candidate graph
+ * or of the tour, and memoized.
+ */
+class SparseOpenTsp {
+
+	/// Exact distance from the start to every node; there's only n of these, so they're evaluated up-front.
+	std::vector<double> from_start;
+
+	std::function<double(size_t, size_t)> between;
+
+	/// Memoized exact distances, keyed by min(i,j) * (n+1) + max(i,j).
+	mutable std::unordered_map<size_t, double> memo;
+
+public:
+	/// Number of nodes, not counting the start.
+	const size_t n;
+
+	/// Position of every node, with the start's position at index n.
+	std::vector<Eigen::Vector3d> positions;
+
+	/// Candidate neighbours of every node, nearest first. Index n holds the candidates for the start.
+	std::vector<std::vector<size_t>> candidates;
+
+	/**
+	 * Build the candidate graph with a GNAT over the node positions.
+	 *
+	 * @param start_position 	Position of the start, used to find its candidates.
+	 * @param positions 		Position of every node.
+	 * @param from_start 		Exact distance from the start to a node.
+	 * @param between 			Exact distance between two nodes; assumed symmetric.
+	 * @param k 				Number of candidate neighbours per node.
+	 */
+	SparseOpenTsp(const Eigen::Vector3d &start_position,
+				  const std::vector<Eigen::Vector3d> &positions,
+				  const std::function<double(size_t)> &from_start,
+				  std::function<double(size_t, size_t)> between,
+				  size_t k);
+
+	[[nodiscard]] size_t start() const {
+		return n;
+	}
+
+	/// The exact distance between two nodes (either of which may be the start), evaluated at most once per pair.
+	[[nodiscard]] double distance(size_t i, size_t j) const;
+
+	/// How many distinct exact distances between non-start nodes have been evaluated so far.
+	[[nodiscard]] size_t evaluated_distances() const {
+		return memo.size();
+	}
+};
+
+/**
+ * Solve a SparseOpenTsp using a nearest-neighbour construction, followed by 2-opt and Or-opt
+ * moves restricted to the candidate graph.
+ *
+ * Like solve_open_tsp_local_search, this returns the best tour so far if the ptc triggers.
+ */
+std::vector<size_t> solve_sparse_open_tsp(const SparseOpenTsp &problem, const ompl::base::PlannerTerminationCondition &ptc);
+
+#endif //NEW_PLANNERS_SPARSE_TSP_H
@@ -0,0 +1,113 @@
+#include "thread_rng.h"
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <random>
+
+namespace {
+	uint64_t splitmix64(uint64_t &state) {
+		uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	/// The high 64 bits of the 128-bit product, without relying on a 128-bit integer type.
+	uint64_t mulhi64(uint64_t a, uint64_t b) {
+		const uint64_t a_lo = (uint32_t) a, a_hi = a >> 32;
+		const uint64_t b_lo = (uint32_t) b, b_hi = b >> 32;
+
+		const uint64_t lo_lo = a_lo * b_lo;
+		const uint64_t hi_lo = a_hi * b_lo;
+		const uint64_t lo_hi = a_lo * b_hi;
+		const uint64_t hi_hi = a_hi * b_hi;
+
+		const uint64_t cross = (lo_lo >> 32) + (uint32_t) hi_lo + lo_hi;
+
+		return hi_hi + (hi_lo >> 32) + (cross >> 32);
+	}
+
+	/// Seed for the next thread that uses thread_rng() without seeding it; the system entropy source is only read once.
+	uint64_t next_thread_seed() {
+		static const uint64_t process_seed = ((uint64_t) std::random_device()() << 32) ^ std::random_device()();
+		static std::atomic<uint64_t> thread_counter{0};
+
+		uint64_t state = process_seed + thread_counter++;
+		return splitmix64(state);
+	}
+
+	/// The generators of a single thread; the OMPL and MoveIt ones are only created if used.
+	struct ThreadRngs {
+		Xoshiro256 fast{next_thread_seed()};
+		std::unique_ptr<ompl::RNG> ompl_rng;
+		std::unique_ptr<random_numbers::RandomNumberGenerator> moveit_rng;
+	};
+
+	ThreadRngs &thread_rngs() {
+		thread_local ThreadRngs rngs;
+		return rngs;
+	}
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed) {
+	for (auto &word: s) {
+		word = splitmix64(seed);
+	}
+}
+
+int Xoshiro256::uniformInt(int lower_bound, int upper_bound) {
+	const auto range = (uint64_t) ((int64_t) upper_bound - (int64_t) lower_bound) + 1;
+	// Multiply-shift rather than modulo; the bias is negligible for the small ranges we use.
+	return lower_bound + (int) mulhi64((*this)(), range);
+}
+
+double Xoshiro256::gaussian01() {
+
+	if (has_spare_gaussian) {
+		has_spare_gaussian = false;
+		return spare_gaussian;
+	}
+
+	// Marsaglia's polar method.
+	double u, v, r2;
+	do {
+		u = uniformReal(-1.0, 1.0);
+		v = uniformReal(-1.0, 1.0);
+		r2 = u * u + v * v;
+	} while (r2 >= 1.0 || r2 == 0.0);
+
+	const double factor = std::sqrt(-2.0 * std::log(r2) / r2);
+
+	spare_gaussian = v * factor;
+	has_spare_gaussian = true;
+
+	return u * factor;
+}
+
+Xoshiro256 &thread_rng() {
+	return thread_rngs().fast;
+}
+
+ompl::RNG &thread_ompl_rng() {
+	auto &rngs = thread_rngs();
+	if (!rngs.ompl_rng) {
+		rngs.ompl_rng = std::make_unique<ompl::RNG>((std::uint_fast32_t) rngs.fast());
+	}
+	return *rngs.ompl_rng;
+}
+
+random_numbers::RandomNumberGenerator &thread_moveit_rng() {
+	auto &rngs = thread_rngs();
+	if (!rngs.moveit_rng) {
+		rngs.moveit_rng = std::make_unique<random_numbers::RandomNumberGenerator>((uint32_t) rngs.fast());
+	}
+	return *rngs.moveit_rng;
+}
+
+void seed_thread_rng(uint64_t seed) {
+	auto &rngs = thread_rngs();
+	rngs.fast = Xoshiro256(seed);
+	rngs.ompl_rng.reset();
+	rngs.moveit_rng.reset();
+}
@@ -0,0 +1,104 @@
+#ifndef NEW_PLANNERS_THREAD_RNG_H
+#define NEW_PLANNERS_THREAD_RNG_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <ompl/util/RandomNumbers.h>
+#include <random_numbers/random_numbers.h>
+
+/**
+ * The xoshiro256** generator: small, fast, and good enough for sampling, with a few convenience
+ * methods named after their ompl::RNG counterparts.
+ *
+ * Satisfies UniformRandomBitGenerator, so it also works with the <random> distributions.
+ */
+class Xoshiro256 {
+
+	std::array<uint64_t, 4> s{};
+
+	/// Spare normal deviate from the previous gaussian01() call, since the polar method generates them in pairs.
+	double spare_gaussian = 0.0;
+	bool has_spare_gaussian = false;
+
+public:
+	typedef uint64_t result_type;
+
+	/// Seed the state through SplitMix64, as recommended by the authors of xoshiro.
+	explicit Xoshiro256(uint64_t seed);
+
+	static constexpr result_type min() {
+		return 0;
+	}
+
+	static constexpr result_type max() {
+		return std::numeric_limits<result_type>::max();
+	}
+
+	result_type operator()() {
+		const uint64_t result = rotl(s[1] * 5, 7) * 9;
+		const uint64_t t = s[1] << 17;
+
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+
+		return result;
+	}
+
+	/// Uniform in [0, 1), with 53 bits of precision.
+	double uniform01() {
+		return (double) ((*this)() >> 11) * 0x1.0p-53;
+	}
+
+	/// Uniform in [lower_bound, upper_bound).
+	double uniformReal(double lower_bound, double upper_bound) {
+		return lower_bound + (upper_bound - lower_bound) * uniform01();
+	}
+
+	/// Uniform in [lower_bound, upper_bound], both inclusive (like ompl::RNG::uniformInt).
+	int uniformInt(int lower_bound, int upper_bound);
+
+	/// Standard normal distribution.
+	double gaussian01();
+
+	double gaussian(double mean, double stddev) {
+		return mean + stddev * gaussian01();
+	}
+
+private:
+	static uint64_t rotl(uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+};
+
+/**
+ * The calling thread's generator, seeded from a process-wide seed and a per-thread counter on first use.
+ *
+ * Constructing an ompl::RNG or random_numbers::RandomNumberGenerator takes a global lock and (by default)
+ * reads a system entropy source, which is far too expensive for the inner loops of samplers; use this instead.
+ */
+Xoshiro256 &thread_rng();
+
+/**
+ * The calling thread's ompl::RNG, for the OMPL functions that require one (such as uniformProlateHyperspheroid);
+ * seeded from thread_rng() on first use.
+ */
+ompl::RNG &thread_ompl_rng();
+
+/**
+ * The calling thread's random_numbers::RandomNumberGenerator, for the MoveIt functions that take one
+ * (such as moveit::core::RobotState::setToRandomPositions); seeded from thread_rng() on first use.
+ */
+random_numbers::RandomNumberGenerator &thread_moveit_rng();
+
+/**
+ * Re-seed the calling thread's generators, such that what it samples from now on is reproducible;
+ * for example at the start of every task in a parallel experiment.
+ */
+void seed_thread_rng(uint64_t seed);
+
+#endif //NEW_PLANNERS_THREAD_RNG_H
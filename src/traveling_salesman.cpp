@@ -1,6 +1,9 @@
 #include <moveit/robot_state/robot_state.h>
 #include "traveling_salesman.h"
 #include "general_utilities.h"
+#include "tsp_local_search.h"
+#include "distance_kernels.h"
+#include "k_medoids.h"
 
 #include <boost/range/algorithm/min_element.hpp>
 #include <utility>
@@ -8,10 +11,13 @@
 #include <range/v3/view/transform.hpp>
 #include <range/v3/view/for_each.hpp>
 #include <range/v3/view/enumerate.hpp>
+#include <atomic>
+#include <chrono>
+#include <execution>
+#include <numeric>
+#include <sstream>
 
 
-typedef std::vector<std::vector<int64_t>> Int64DistanceMatrix;
-
 double ordering_heuristic_cost(const std::vector<size_t> &ordering, const std::vector<Apple> &apples,
                                const DistanceHeuristics& dh) {
 
@@ -26,6 +32,24 @@ double ordering_heuristic_cost(const std::vector<size_t> &ordering, const std::v
 
 
 
+std::function<void(size_t, double *)> DistanceHeuristics::between_distance_rows(const std::vector<Apple> &apples) const {
+    return [this, &apples](size_t i, double *out) {
+        for (size_t j = 0; j < apples.size(); ++j) {
+            out[j] = between_distance(apples[i], apples[j]);
+        }
+    };
+}
+
+std::function<void(size_t, double *)> GreatcircleDistanceHeuristics::between_distance_rows(const std::vector<Apple> &apples) const {
+
+    std::vector<Eigen::Vector3d> centers;
+    for (const auto &apple : apples) {
+        centers.push_back(apple.center);
+    }
+
+    return gcm.measure_rows(centers);
+}
+
 double GreatcircleDistanceHeuristics::between_distance(const Apple &apple_a, const Apple &apple_b) const {
     return gcm.measure(apple_a.center, apple_b.center);
 }
@@ -54,6 +78,20 @@ std::string EuclideanDistanceHeuristics::name() {
     return "euclidean";
 }
 
+std::function<void(size_t, double *)> EuclideanDistanceHeuristics::between_distance_rows(const std::vector<Apple> &apples) const {
+
+    std::vector<Eigen::Vector3d> centers;
+    for (const auto &apple : apples) {
+        centers.push_back(apple.center);
+    }
+
+    auto points = std::make_shared<PointsSoA>(PointsSoA::from(centers));
+
+    return [points](size_t i, double *out) {
+        euclidean_distances({points->x[i], points->y[i], points->z[i]}, *points, out);
+    };
+}
+
 EuclideanDistanceHeuristics::EuclideanDistanceHeuristics(Eigen::Vector3d startEndEffectorPos) : start_end_effector_pos(std::move(
         startEndEffectorPos)) {}
 
@@ -105,84 +143,200 @@ std::string ORToolsOrderingStrategy::name() const{
 std::vector<size_t> ORToolsOrderingStrategy::apple_ordering(const std::vector<Apple> &apples,
                                                             const DistanceHeuristics &distance) const {
 
-    return tsp_open_end([&](size_t i) {
+    std::vector<double> from_start;
+    from_start.reserve(apples.size());
+    for (const auto &apple : apples) {
+        from_start.push_back(distance.first_distance(apple));
+    }
+
+    return tsp_open_end_rows(from_start,
+                             distance.between_distance_rows(apples),
+                             ompl::base::plannerNonTerminatingCondition(),
+                             tsp_options);
+
+}
+
+ORToolsOrderingStrategy::ORToolsOrderingStrategy(TspOptions tspOptions) : tsp_options(tspOptions) {
+}
+
+HierarchicalOrderingStrategy::HierarchicalOrderingStrategy(size_t clusterSize, TspOptions tspOptions) : tsp_options(tspOptions) {
+    tsp_options.cluster_size = clusterSize;
+}
+
+std::string HierarchicalOrderingStrategy::name() const {
+    return "hierarchical";
+}
+
+std::vector<size_t> HierarchicalOrderingStrategy::apple_ordering(const std::vector<Apple> &apples,
+                                                                 const DistanceHeuristics &distance) const {
+
+    return tsp_open_end_hierarchical([&](size_t i) {
         return distance.first_distance(apples[i]);
     }, [&](size_t i, size_t j) {
         return distance.between_distance(apples[i], apples[j]);
-    }, apples.size());
+    }, apples.size(), ompl::base::plannerNonTerminatingCondition(), tsp_options);
+
+}
+
+std::string tsp_metaheuristic_name(TspMetaheuristic metaheuristic) {
+	switch (metaheuristic) {
+		case TspMetaheuristic::NONE:
+			return "none";
+		case TspMetaheuristic::GUIDED_LOCAL_SEARCH:
+			return "guided_local_search";
+		case TspMetaheuristic::SIMULATED_ANNEALING:
+			return "simulated_annealing";
+		case TspMetaheuristic::TABU_SEARCH:
+			return "tabu_search";
+	}
+	throw std::runtime_error("Unknown TSP metaheuristic");
+}
 
+void TspObjectiveTrace::addSolve(std::vector<Entry> solutions) {
+	std::lock_guard<std::mutex> lock(mutex);
+	solves.push_back(std::move(solutions));
 }
 
-std::tuple<Int64DistanceMatrix, size_t, size_t> mkOpenEndedDistanceMatrix(const std::function<double(size_t)> &from_start,
-																		  const std::function<double(size_t, size_t)> &between,
-																		  size_t n,
-																		  const ompl::base::PlannerTerminationCondition &ptc) {
+Json::Value TspObjectiveTrace::toJson() const {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Json::Value json(Json::arrayValue);
+	for (const auto &solve: solves) {
+		Json::Value solve_json(Json::arrayValue);
+		for (const auto &[seconds, length]: solve) {
+			Json::Value entry(Json::arrayValue);
+			entry.append(seconds);
+			entry.append(length);
+			solve_json.append(entry);
+		}
+		json.append(solve_json);
+	}
+	return json;
+}
+
+/**
+ * Search parameters for the routing model, as configured in the options.
+ */
+operations_research::RoutingSearchParameters ortools_search_parameters(const TspOptions &options) {
+
+	operations_research::RoutingSearchParameters searchParameters = operations_research::DefaultRoutingSearchParameters();
+	searchParameters.set_first_solution_strategy(operations_research::FirstSolutionStrategy::PATH_CHEAPEST_ARC);
+
+	switch (options.metaheuristic) {
+		case TspMetaheuristic::NONE:
+			break;
+		case TspMetaheuristic::GUIDED_LOCAL_SEARCH:
+			searchParameters.set_local_search_metaheuristic(operations_research::LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH);
+			break;
+		case TspMetaheuristic::SIMULATED_ANNEALING:
+			searchParameters.set_local_search_metaheuristic(operations_research::LocalSearchMetaheuristic::SIMULATED_ANNEALING);
+			break;
+		case TspMetaheuristic::TABU_SEARCH:
+			searchParameters.set_local_search_metaheuristic(operations_research::LocalSearchMetaheuristic::TABU_SEARCH);
+			break;
+	}
+
+	if (options.time_limit > 0.0) {
+		auto seconds = (int64_t) options.time_limit;
+		searchParameters.mutable_time_limit()->set_seconds(seconds);
+		searchParameters.mutable_time_limit()->set_nanos((int32_t) ((options.time_limit - (double) seconds) * 1e9));
+	}
+
+	if (options.solution_limit > 0) {
+		searchParameters.set_solution_limit((int64_t) options.solution_limit);
+	}
+
+	return searchParameters;
+}
+
+std::vector<size_t> solve_open_tsp_ortools(const GroupedOpenTsp &problem,
+										   const ompl::base::PlannerTerminationCondition &ptc,
+										   const TspOptions &options,
+										   const std::vector<size_t> &initial_tour) {
+
+    const size_t n = problem.n;
+    const size_t start_state_index = problem.start();
+    const size_t end_state_index = n + 1;
 
-    Int64DistanceMatrix distance_matrix(n+2, std::vector<int64_t>(n+2));
+    // This allows us to translate OR-tools internal indices into the node indices of the problem,
+    // plus a dummy end node at index N+1 so that the path can end anywhere.
+    operations_research::RoutingIndexManager manager((int) n+2, 1,
+                                                     { operations_research::RoutingIndexManager::NodeIndex {(int) start_state_index } },
+                                                     { operations_research::RoutingIndexManager::NodeIndex {(int) end_state_index } });
+
+    // Build a routing model, reading arc costs straight from the problem rather than copying them
+    // into an integer matrix first. OR-tools requires integer costs, hence the scaling.
+    operations_research::RoutingModel routing(manager);
+    const int transit_callback = routing.RegisterTransitCallback([&](int64_t from_index, int64_t to_index) -> int64_t {
 
-    size_t start_state_index= n;
-    size_t end_state_index= n + 1;// First, we build an (N+2)^2 square symmetric distance matrix.
+        size_t from = (size_t) manager.IndexToNode(from_index).value();
+        size_t to = (size_t) manager.IndexToNode(to_index).value();
 
-    // The top-left NxN part of the matrix is filled with apple-to-apple distances,
-    // where distance_matrix[i][j] contains the distance between apples[i] and apples[j].
-    // Distance matrix is assumed symmetric
-    for (size_t i : boost::irange<size_t>(0,n)) {
-        for (size_t j : boost::irange<size_t>(i,n)) {
-            distance_matrix[i][j] = (int64_t) (between(i,j) * 1000.0);
-            // Lower triangle is filled by symmetry
-            distance_matrix[j][i] = distance_matrix[i][j];
+        // The dummy end node has a 0-cost edge to every other node.
+        if (from == end_state_index || to == end_state_index) {
+            return 0;
         }
-		checkPtc(ptc);
-    }
 
-    // The distance_matrix[N] column contains the distance between the start state and the apple.
-    // Also, the distance_matrix[..][N] row is built by symmetry.
+        return (int64_t) (problem.distance(from, to) * 1000.0);
+    });
+    routing.SetArcCostEvaluatorOfAllVehicles(transit_callback);
 
-    for (size_t i : boost::irange<size_t>(0,n)) {
-        distance_matrix[i][n] = (int64_t) (from_start(i) * 1000.0);;
-        distance_matrix[n][i] = distance_matrix[i][n];
+    // Set up the disjunctions, to allow the router to only visit every group once.
+    for (const auto &members : problem.group_members) {
+        if (members.size() >= 2) {
+            routing.AddDisjunction(std::vector<int64_t>(members.begin(), members.end()));
+        }
     }
 
-    // Traveling from the start state to itself is free.
-    distance_matrix[start_state_index][start_state_index] = 0;
+    operations_research::RoutingSearchParameters searchParameters = ortools_search_parameters(options);
+
+    // Stop searching once the planner runs out of time; OR-tools then returns the best solution found so far.
+    routing.AddSearchMonitor(routing.solver()->MakeCustomLimit([&ptc]() {
+        return ptc();
+    }));
 
-    // We add a "dummy" node to visit as the required end position, with a 0-cost edge to every other node.
-    for (size_t i : boost::irange<size_t>(0,n+2)) {
-        distance_matrix[i][end_state_index] = 0;
-        distance_matrix[end_state_index][i] = 0;
+    std::vector<TspObjectiveTrace::Entry> solutions;
+    auto solve_start = std::chrono::steady_clock::now();
+
+    if (options.objective_trace) {
+        routing.AddAtSolutionCallback([&]() {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - solve_start;
+            solutions.emplace_back(elapsed.count(), (double) routing.CostVar()->Value() / 1000.0);
+        });
     }
-    
-    return std::make_tuple(
-            distance_matrix,
-            start_state_index,
-            end_state_index
-            );
-}
 
-std::vector<size_t> tsp_open_end(
-		const std::function<double(size_t)> &from_start,
-		const std::function<double(size_t, size_t)> &between,
-		size_t n,
-		const ompl::base::PlannerTerminationCondition &ptc) {
-    
-    const auto &[distance_matrix, start_state_index, end_state_index] =
-            mkOpenEndedDistanceMatrix(from_start, between, n, ptc);
+    const operations_research::Assignment* solution = nullptr;
 
-    // This allows us to translate OR-tools internal indices into the indices of the table above.
-    operations_research::RoutingIndexManager manager((int) n+2, 1,
-                                                     { operations_research::RoutingIndexManager::NodeIndex {(int) start_state_index } },
-                                                     { operations_research::RoutingIndexManager::NodeIndex {(int) end_state_index } });
+    if (!initial_tour.empty()) {
 
-    // Build a routing model, and register the distance matrix.
-    operations_research::RoutingModel routing(manager);
-    routing.SetArcCostEvaluatorOfAllVehicles(routing.RegisterTransitMatrix(distance_matrix));
+        routing.CloseModelWithParameters(searchParameters);
+
+        std::vector<int64_t> route;
+        for (size_t node : repair_tour(problem, initial_tour)) {
+            route.push_back(manager.NodeToIndex(operations_research::RoutingIndexManager::NodeIndex {(int) node }));
+        }
+
+        // This may fail if the initial tour violates a constraint, in which case we just solve from scratch.
+        if (const auto *initial_assignment = routing.ReadAssignmentFromRoutes({route}, true)) {
+            solution = routing.SolveFromAssignmentWithParameters(initial_assignment, searchParameters);
+        }
+    }
 
-    operations_research::RoutingSearchParameters searchParameters = operations_research::DefaultRoutingSearchParameters();
-    searchParameters.set_first_solution_strategy(operations_research::FirstSolutionStrategy::PATH_CHEAPEST_ARC);
+    if (!solution) {
+        solution = routing.SolveWithParameters(searchParameters);
+    }
 
-    const operations_research::Assignment* solution = routing.SolveWithParameters(searchParameters);
+    if (options.objective_trace) {
+        options.objective_trace->addSolve(std::move(solutions));
+    }
 
-    // Translate the internal ordering into an ordering on the apples.
+    if (!solution) {
+        // Only happens if a limit was reached before even a first solution was found.
+        checkPtc(ptc);
+        throw std::runtime_error("OR-tools did not find a solution within the limits");
+    }
+
+    // Translate the internal ordering into an ordering on the nodes.
     std::vector<size_t> ordering;
 
     for (int64_t index = routing.Start(0); !routing.IsEnd(index); index = solution->Value(routing.NextVar(index))) {
@@ -198,6 +352,282 @@ std::vector<size_t> tsp_open_end(
     return ordering;
 }
 
+std::string tsp_solver_name(TspSolver solver) {
+	switch (solver) {
+		case TspSolver::ORTOOLS:
+			return "ortools";
+		case TspSolver::LOCAL_SEARCH:
+			return "local_search";
+	}
+	throw std::runtime_error("Unknown TSP solver");
+}
+
+Json::Value TspOptions::parameters() const {
+	Json::Value result;
+	result["solver"] = tsp_solver_name(solver);
+	result["lazy_distances"] = lazy_distances;
+	result["parallel_distances"] = parallel_distances;
+	result["sparse_neighbours"] = (int) sparse_neighbours;
+	result["cluster_size"] = (int) cluster_size;
+	result["memo"] = memo != nullptr;
+	result["metaheuristic"] = tsp_metaheuristic_name(metaheuristic);
+	result["time_limit"] = time_limit;
+	result["solution_limit"] = (int) solution_limit;
+	result["exact_threshold"] = (int) exact_threshold;
+	return result;
+}
+
+std::string TspOptions::memoKey() const {
+	std::stringstream ss;
+	ss << tsp_solver_name(solver) << "," << tsp_metaheuristic_name(metaheuristic)
+	   << ",t" << time_limit << ",s" << solution_limit << ",e" << exact_threshold
+	   << ",n" << sparse_neighbours << ",c" << cluster_size;
+	return ss.str();
+}
+
+std::vector<size_t> solve_open_tsp(const GroupedOpenTsp &problem,
+								   const ompl::base::PlannerTerminationCondition &ptc,
+								   const TspOptions &options,
+								   const std::vector<size_t> &initial_tour) {
+
+	// For small problems, an exact solution is cheaper than starting up a heuristic solver.
+	if (options.exact_threshold > 0 && exact_tsp_supported(problem, options.exact_threshold)) {
+		try {
+			return solve_open_tsp_exact(problem, ptc);
+		} catch (const std::runtime_error &) {
+			// No finite tour reconstructed; the heuristic solvers below still visit every group.
+		}
+	}
+
+	switch (options.solver) {
+		case TspSolver::ORTOOLS:
+			return solve_open_tsp_ortools(problem, ptc, options, initial_tour);
+		case TspSolver::LOCAL_SEARCH:
+			return solve_open_tsp_local_search(problem, ptc, initial_tour);
+	}
+	throw std::runtime_error("Unknown TSP solver");
+}
+
+std::vector<size_t> solve_open_tsp_lazy(GroupedOpenTsp &problem,
+										const std::function<double(size_t, size_t)> &between,
+										const ompl::base::PlannerTerminationCondition &ptc,
+										const TspOptions &options) {
+
+	// Which entries of the matrix have been replaced by their exact value. Start distances are always exact.
+	std::vector<bool> exact(problem.distances.packed_size(), false);
+
+	auto tour = solve_open_tsp(problem, ptc, options);
+
+	// Every iteration makes at least one more entry exact, so this terminates even without the ptc.
+	while (!ptc()) {
+
+		bool any_updated = false;
+
+		for (size_t k = 1; k < tour.size(); ++k) {
+
+			size_t i = tour[k - 1], j = tour[k];
+
+			if (!exact[problem.distances.index(i, j)]) {
+				problem.setDistance(i, j, between(i, j));
+				exact[problem.distances.index(i, j)] = true;
+				any_updated = true;
+			}
+		}
+
+		// All edges of the tour are exact, and all the others are at most their exact value: the tour is stable.
+		if (!any_updated) {
+			break;
+		}
+
+		// The previous tour is usually close to the new optimum, so start from there.
+		tour = solve_open_tsp(problem, ptc, options, tour);
+	}
+
+	return tour;
+}
+
+std::vector<size_t> tsp_open_end(
+		const std::function<double(size_t)> &from_start,
+		const std::function<double(size_t, size_t)> &between,
+		size_t n,
+		const ompl::base::PlannerTerminationCondition &ptc,
+		const TspOptions &options,
+		const std::vector<size_t> &initial_tour) {
+
+	auto problem = GroupedOpenTsp::build(from_start, between, std::vector<size_t>(n, 1), ptc, options.parallel_distances);
+
+	// With singleton groups, node indices are the same as the item indices.
+	return solve_open_tsp(problem, ptc, options, initial_tour);
+}
+
+std::vector<size_t> tsp_open_end_rows(
+		const std::vector<double> &from_start,
+		const std::function<void(size_t, double *)> &between_rows,
+		const ompl::base::PlannerTerminationCondition &ptc,
+		const TspOptions &options,
+		const std::vector<size_t> &initial_tour) {
+
+	auto problem = GroupedOpenTsp::buildFromRows(from_start,
+												 between_rows,
+												 std::vector<size_t>(from_start.size(), 1),
+												 ptc,
+												 options.parallel_distances);
+
+	return solve_open_tsp(problem, ptc, options, initial_tour);
+}
+
+
+std::vector<size_t> tsp_open_end_sparse(
+		const Eigen::Vector3d &start_position,
+		const std::vector<Eigen::Vector3d> &positions,
+		const std::function<double(size_t)> &from_start,
+		const std::function<double(size_t, size_t)> &between,
+		const ompl::base::PlannerTerminationCondition &ptc,
+		const TspOptions &options) {
+
+	SparseOpenTsp problem(start_position, positions, from_start, between, options.sparse_neighbours);
+
+	return solve_sparse_open_tsp(problem, ptc);
+}
+
+/// Size of the window around every cluster boundary that tsp_open_end_hierarchical smooths with 2-opt, on either side.
+const size_t HIERARCHICAL_BOUNDARY_WINDOW = 8;
+
+/**
+ * Apply 2-opt to tour[lo..=hi] until no reversal within that range makes the whole tour shorter.
+ */
+void two_opt_window(std::vector<size_t> &tour,
+					size_t lo,
+					size_t hi,
+					const std::function<double(size_t)> &from_start,
+					const std::function<double(size_t, size_t)> &between) {
+
+	// Distance from the item at tour position `from` (-1 being the start) to the one at `to` (tour.size() being the open end).
+	auto d = [&](size_t from_item, size_t to_position) {
+		if (to_position >= tour.size()) {
+			return 0.0;
+		}
+		return from_item == SIZE_MAX ? from_start(tour[to_position]) : between(from_item, tour[to_position]);
+	};
+
+	bool improved = true;
+
+	while (improved) {
+		improved = false;
+
+		for (size_t i = lo; i < hi; ++i) {
+			for (size_t j = i + 1; j <= hi; ++j) {
+
+				size_t before_i = i == 0 ? SIZE_MAX : tour[i - 1];
+
+				double current = d(before_i, i) + d(tour[j], j + 1);
+				double reversed = d(before_i, j) + d(tour[i], j + 1);
+
+				if (reversed < current - 1.0e-9) {
+					std::reverse(tour.begin() + (long) i, tour.begin() + (long) j + 1);
+					improved = true;
+				}
+			}
+		}
+	}
+}
+
+std::vector<size_t> tsp_open_end_hierarchical(
+		const std::function<double(size_t)> &from_start,
+		const std::function<double(size_t, size_t)> &between,
+		size_t n,
+		const ompl::base::PlannerTerminationCondition &ptc,
+		const TspOptions &options,
+		const std::vector<size_t> &initial_tour) {
+
+	if (options.cluster_size == 0 || n <= options.cluster_size) {
+		return tsp_open_end(from_start, between, n, ptc, options, initial_tour);
+	}
+
+	// Seed the clustering with the item nearest to the start.
+	size_t nearest_to_start = 0;
+	for (size_t i = 1; i < n; ++i) {
+		if (from_start(i) < from_start(nearest_to_start)) {
+			nearest_to_start = i;
+		}
+	}
+
+	auto clustering = k_medoids(n, (n + options.cluster_size - 1) / options.cluster_size, between, nearest_to_start);
+
+	checkPtc(ptc);
+
+	const auto &medoids = clustering.medoids;
+
+	auto cluster_order = tsp_open_end([&](size_t i) {
+		return from_start(medoids[i]);
+	}, [&](size_t i, size_t j) {
+		return between(medoids[i], medoids[j]);
+	}, medoids.size(), ptc, options);
+
+	// Route every cluster separately, entering from the medoid of the cluster before it.
+	std::vector<std::vector<size_t>> cluster_tours(cluster_order.size());
+
+	// Exceptions escaping a parallel algorithm call std::terminate, so a timeout is signalled through a flag instead.
+	std::atomic<bool> timed_out{false};
+
+	auto route_cluster = [&](size_t k) {
+
+		const auto &members = clustering.members[cluster_order[k]];
+
+		if (members.empty()) {
+			return;
+		}
+
+		try {
+			auto cluster_tour = tsp_open_end([&](size_t i) {
+				return k == 0 ? from_start(members[i]) : between(medoids[cluster_order[k - 1]], members[i]);
+			}, [&](size_t i, size_t j) {
+				return between(members[i], members[j]);
+			}, members.size(), ptc, options);
+
+			for (size_t i: cluster_tour) {
+				cluster_tours[k].push_back(members[i]);
+			}
+		} catch (PlanningTimeout &) {
+			timed_out = true;
+		}
+	};
+
+	std::vector<size_t> cluster_indices(cluster_order.size());
+	std::iota(cluster_indices.begin(), cluster_indices.end(), 0);
+
+	if (options.parallel_distances) {
+		std::for_each(std::execution::par, cluster_indices.begin(), cluster_indices.end(), route_cluster);
+	} else {
+		std::for_each(cluster_indices.begin(), cluster_indices.end(), route_cluster);
+	}
+
+	if (timed_out) {
+		throw PlanningTimeout();
+	}
+
+	// Stitch the cluster tours together, and smooth out the transitions between them.
+	std::vector<size_t> tour;
+	tour.reserve(n);
+
+	for (const auto &cluster_tour: cluster_tours) {
+
+		if (!tour.empty() && !cluster_tour.empty()) {
+			size_t boundary = tour.size();
+
+			tour.insert(tour.end(), cluster_tour.begin(), cluster_tour.end());
+
+			size_t lo = boundary > HIERARCHICAL_BOUNDARY_WINDOW ? boundary - HIERARCHICAL_BOUNDARY_WINDOW : 0;
+			size_t hi = std::min(tour.size() - 1, boundary + HIERARCHICAL_BOUNDARY_WINDOW - 1);
+
+			two_opt_window(tour, lo, hi, from_start, between);
+		} else {
+			tour.insert(tour.end(), cluster_tour.begin(), cluster_tour.end());
+		}
+	}
+
+	return tour;
+}
 
 std::vector<std::pair<size_t, size_t>> flatten_indices(const std::vector<size_t> &sizes) {
     std::vector<std::pair<size_t, size_t>> index_pairs;
@@ -213,67 +643,54 @@ std::vector<std::pair<size_t, size_t>>
 tsp_open_end_grouped(const std::function<double(std::pair<size_t, size_t>)> &from_start,
 					 const std::function<double(std::pair<size_t, size_t>, std::pair<size_t, size_t>)> &between,
 					 const std::vector<size_t> &sizes,
-					 ompl::base::PlannerTerminationCondition &ptc) {
+					 ompl::base::PlannerTerminationCondition &ptc,
+					 const TspOptions &options) {
 
-    // Sum up all sizes
+    // GroupedOpenTsp numbers nodes in the same order as flatten_indices.
     auto index_lookup = flatten_indices(sizes);
 
-    size_t n = index_lookup.size();
-
     std::cout << "Building TSP distance matrix." << std::endl;
 
-    const auto &[distance_matrix, start_state_index, end_state_index] =
-            mkOpenEndedDistanceMatrix(
-                    [&](size_t i) {
-                        return from_start(index_lookup[i]);
-                    },
-                    [&](size_t i, size_t j) {
-                        return between(index_lookup[i], index_lookup[j]);
-                    },
-                    n,
-					ptc);
+    auto problem = GroupedOpenTsp::build([&](size_t i) {
+        return from_start(index_lookup[i]);
+    }, [&](size_t i, size_t j) {
+        return between(index_lookup[i], index_lookup[j]);
+    }, sizes, ptc, options.parallel_distances);
 
     std::cout << "Solving the routing problem..." << std::endl;
 
-    // This allows us to translate OR-tools internal indices into the indices of the table above.
-    operations_research::RoutingIndexManager manager((int) n+2, 1,
-                                                     { operations_research::RoutingIndexManager::NodeIndex {(int) start_state_index } },
-                                                     { operations_research::RoutingIndexManager::NodeIndex {(int) end_state_index } });
-
-    // Build a routing model, and register the distance matrix.
-    operations_research::RoutingModel routing(manager);
-    routing.SetArcCostEvaluatorOfAllVehicles(routing.RegisterTransitMatrix(distance_matrix));
-
-    // Set up the disjunctions, to allow the router to only visit every group once.
-    size_t last_index = 0;
-    std::vector<std::pair<size_t, size_t>> index_pairs;
-    for (size_t i : boost::irange<size_t>(0,sizes.size())) {
-        std::vector<int64_t> disjunction_indices;
-        for (size_t j : boost::irange<size_t>(0,sizes[i])) {
-            disjunction_indices.emplace_back(last_index++);
-        }
-        if (disjunction_indices.size() >= 2) {
-            routing.AddDisjunction(disjunction_indices);
-        }
+    std::vector<std::pair<size_t, size_t>> ordering;
+    for (size_t node : solve_open_tsp(problem, ptc, options)) {
+        ordering.push_back(index_lookup[node]);
     }
 
-    operations_research::RoutingSearchParameters searchParameters = operations_research::DefaultRoutingSearchParameters();
-    searchParameters.set_first_solution_strategy(operations_research::FirstSolutionStrategy::PATH_CHEAPEST_ARC);
+    return ordering;
+}
 
-    const operations_research::Assignment* solution = routing.SolveWithParameters(searchParameters);
+std::vector<std::pair<size_t, size_t>>
+tsp_open_end_grouped_lazy(const std::function<double(std::pair<size_t, size_t>)> &from_start,
+						  const std::function<double(std::pair<size_t, size_t>, std::pair<size_t, size_t>)> &between,
+						  const std::function<double(std::pair<size_t, size_t>, std::pair<size_t, size_t>)> &between_lower_bound,
+						  const std::vector<size_t> &sizes,
+						  ompl::base::PlannerTerminationCondition &ptc,
+						  const TspOptions &options) {
 
-    // Translate the internal ordering into an ordering on the apples.
-    std::vector<std::pair<size_t, size_t>> ordering;
+    auto index_lookup = flatten_indices(sizes);
 
-    for (int64_t index = routing.Start(0); !routing.IsEnd(index); index = solution->Value(routing.NextVar(index))) {
+    auto problem = GroupedOpenTsp::build([&](size_t i) {
+        return from_start(index_lookup[i]);
+    }, [&](size_t i, size_t j) {
+        return between_lower_bound(index_lookup[i], index_lookup[j]);
+    }, sizes, ptc, options.parallel_distances);
 
-        size_t node_index = (size_t) manager.IndexToNode(index).value();
+    auto tour = solve_open_tsp_lazy(problem, [&](size_t i, size_t j) {
+        return between(index_lookup[i], index_lookup[j]);
+    }, ptc, options);
 
-        // Exclude the dummy start-and-end nodes.
-        if (node_index != start_state_index && node_index != end_state_index) {
-            ordering.push_back(index_lookup[node_index]);
-        }
+    std::vector<std::pair<size_t, size_t>> ordering;
+    for (size_t node : tour) {
+        ordering.push_back(index_lookup[node]);
     }
 
     return ordering;
-}
\ No newline at end of file
+}
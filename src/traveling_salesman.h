@@ -7,15 +7,120 @@
 #include <ortools/constraint_solver/routing_parameters.h>
 #include <boost/range/irange.hpp>
 #include <utility>
+#include <mutex>
 #include <ompl/base/PlannerTerminationCondition.h>
+#include <json/json.h>
 #include "procedural_tree_generation.h"
 #include "GreatCircleMetric.h"
+#include "tsp_local_search.h"
+#include "sparse_tsp.h"
+#include "held_karp.h"
+#include "TspMemo.h"
+
+/// Which solver to use for the open-ended TSP problems below.
+enum class TspSolver {
+	/// OR-tools' RoutingModel, with a PATH_CHEAPEST_ARC first solution, improved with TspOptions::metaheuristic
+	/// until the ptc triggers or one of the limits in the TspOptions is reached.
+	ORTOOLS,
+	/// The built-in nearest-neighbour + 2-opt/Or-opt solver from tsp_local_search.h; returns the best tour so far when the ptc triggers.
+	LOCAL_SEARCH
+};
+
+std::string tsp_solver_name(TspSolver solver);
+
+/// Metaheuristic OR-tools uses to escape local minima after finding a first solution.
+enum class TspMetaheuristic {
+	/// Stop at the first local minimum.
+	NONE,
+	GUIDED_LOCAL_SEARCH,
+	SIMULATED_ANNEALING,
+	TABU_SEARCH
+};
+
+std::string tsp_metaheuristic_name(TspMetaheuristic metaheuristic);
+
+/**
+ * Objective values of the solutions OR-tools finds over time, for every solve it is passed to (see TspOptions).
+ * Thread-safe, since hierarchical routing may solve several problems at once.
+ */
+class TspObjectiveTrace {
+
+public:
+	/// A solution: seconds since the start of the solve, and the tour length.
+	typedef std::pair<double, double> Entry;
+
+private:
+	std::vector<std::vector<Entry>> solves;
+
+	/// Guards `solves`
+	mutable std::mutex mutex;
+
+public:
+	/**
+	 * Record the solutions found during one solve.
+	 */
+	void addSolve(std::vector<Entry> solutions);
+
+	/**
+	 * An array with, for every solve, an array of [seconds, length] pairs.
+	 */
+	[[nodiscard]] Json::Value toJson() const;
+};
+
+struct TspOptions {
+	TspSolver solver = TspSolver::ORTOOLS;
+
+	/// Whether planners should use the lazy variants below when they have a cheap lower bound on their distances.
+	bool lazy_distances = false;
+
+	/// Whether to evaluate the rows of the distance matrix in parallel. Only safe if the distance functions are thread-safe.
+	bool parallel_distances = false;
+
+	/// If non-zero, planners that know the positions of their goals use tsp_open_end_sparse with this many neighbours.
+	size_t sparse_neighbours = 0;
+
+	/// If non-zero, planners use tsp_open_end_hierarchical with clusters of about this many goals.
+	size_t cluster_size = 0;
+
+	/// If set, planners look up and store their orderings here, so identical ordering problems are only solved once.
+	std::shared_ptr<TspMemo> memo;
+
+	/// Metaheuristic for the OR-tools solver; anything but NONE keeps improving the tour until a limit is reached,
+	/// so it should be combined with a time limit or a ptc that eventually triggers.
+	TspMetaheuristic metaheuristic = TspMetaheuristic::NONE;
+
+	/// Upper bound on the time (in seconds) OR-tools spends on one solve; 0 for none. Solving also stops when the ptc triggers.
+	double time_limit = 0.0;
+
+	/// Number of solutions after which OR-tools stops; 0 for no limit.
+	size_t solution_limit = 0;
+
+	/// If set, OR-tools records the length of every solution it finds here.
+	std::shared_ptr<TspObjectiveTrace> objective_trace;
+
+	/// Problems with at most this many groups are solved to optimality with solve_open_tsp_exact, whichever solver
+	/// is selected; 0 to disable. Keep this well below EXACT_TSP_MAX_GROUPS, since the cost doubles with every group.
+	size_t exact_threshold = 12;
+
+	[[nodiscard]] Json::Value parameters() const;
+
+	/// The options that affect which ordering is found, for the TspMemo key.
+	[[nodiscard]] std::string memoKey() const;
+};
 
 class DistanceHeuristics {
 public:
     [[nodiscard]] virtual std::string name() = 0;
     [[nodiscard]] virtual double first_distance(const Apple &) const = 0;
     [[nodiscard]] virtual double between_distance(const Apple &, const Apple &) const = 0;
+
+    /**
+     * Produce a function that, given the index i of an apple, writes the between_distance from apples[i]
+     * to every apple into an output array. The function must be thread-safe.
+     *
+     * The default calls between_distance for every pair; subclasses can override this with a batched kernel.
+     */
+    [[nodiscard]] virtual std::function<void(size_t, double *)> between_distance_rows(const std::vector<Apple> &apples) const;
 };
 
 class EuclideanDistanceHeuristics : public DistanceHeuristics {
@@ -30,6 +135,8 @@ public:
     [[nodiscard]] double first_distance(const Apple &apple) const override;
 
     [[nodiscard]] double between_distance(const Apple &apple_a, const Apple &apple_b) const override;
+
+    [[nodiscard]] std::function<void(size_t, double *)> between_distance_rows(const std::vector<Apple> &apples) const override;
 };
 
 class GreatcircleDistanceHeuristics : public DistanceHeuristics {
@@ -46,6 +153,8 @@ public:
     [[nodiscard]] double first_distance(const Apple &apple) const override;
 
     [[nodiscard]] double between_distance(const Apple &apple_a, const Apple &apple_b) const override;
+
+    [[nodiscard]] std::function<void(size_t, double *)> between_distance_rows(const std::vector<Apple> &apples) const override;
 };
 
 class OrderingStrategy {
@@ -63,7 +172,32 @@ public:
 };
 
 class ORToolsOrderingStrategy : public OrderingStrategy {
+
+	TspOptions tsp_options;
+
+public:
+    explicit ORToolsOrderingStrategy(TspOptions tspOptions = {});
+
+    [[nodiscard]] std::string name() const override;
+
+    [[nodiscard]] std::vector<size_t> apple_ordering(const std::vector<Apple> &apples, const DistanceHeuristics &distance) const override;
+
+};
+
+/**
+ * Cluster the apples, route between the clusters and then within each of them; see tsp_open_end_hierarchical.
+ */
+class HierarchicalOrderingStrategy : public OrderingStrategy {
+
+	TspOptions tsp_options;
+
 public:
+    /**
+     * @param clusterSize 	Roughly how many apples to put in a cluster.
+     * @param tspOptions 	Options for the individual TSP problems; its cluster_size is overridden by clusterSize.
+     */
+    explicit HierarchicalOrderingStrategy(size_t clusterSize, TspOptions tspOptions = {});
+
     [[nodiscard]] std::string name() const override;
 
     [[nodiscard]] std::vector<size_t> apple_ordering(const std::vector<Apple> &apples, const DistanceHeuristics &distance) const override;
@@ -74,16 +208,108 @@ double ordering_heuristic_cost(const std::vector<size_t>& ordering,
                                const std::vector<Apple>& apples,
                                const DistanceHeuristics& dh);
 
+/**
+ * Solve an already-built problem with the solver selected in the options,
+ * or exactly if it has at most options.exact_threshold groups.
+ *
+ * @param initial_tour 	Optional warm start; see repair_tour for what is accepted.
+ */
+std::vector<size_t> solve_open_tsp(const GroupedOpenTsp &problem,
+								   const ompl::base::PlannerTerminationCondition &ptc,
+								   const TspOptions &options,
+								   const std::vector<size_t> &initial_tour = {});
+
+/**
+ * Solve a problem whose distance matrix holds lower bounds on the true distances (except for the start distances,
+ * which must be exact), only evaluating the true distance for edges that appear in a tour.
+ *
+ * After every solve, the edges of the tour are replaced with their true distance in the problem, and the problem
+ * is solved again. Once a tour consists only of exact edges, every other edge is at most as expensive
+ * as it really is, so the tour is stable and returned. Returns the latest tour if the ptc triggers.
+ *
+ * @param problem 	The problem, with lower bounds in the matrix; updated with the exact distances evaluated.
+ * @param between 	The exact distance between two nodes.
+ */
+std::vector<size_t> solve_open_tsp_lazy(GroupedOpenTsp &problem,
+										const std::function<double(size_t, size_t)> &between,
+										const ompl::base::PlannerTerminationCondition &ptc,
+										const TspOptions &options);
+
+/**
+ * Find a short path from the start through all n items, ending anywhere.
+ *
+ * @param initial_tour 	Optional warm start, for instance the previous ordering when the set of items changed only
+ * 						slightly. Items beyond n are dropped and missing items are inserted.
+ */
 std::vector<size_t> tsp_open_end(
 		const std::function<double(size_t)> &from_start,
 		const std::function<double(size_t,size_t)> & between,
 		size_t n,
-		const ompl::base::PlannerTerminationCondition &ptc = ompl::base::plannerNonTerminatingCondition());
+		const ompl::base::PlannerTerminationCondition &ptc = ompl::base::plannerNonTerminatingCondition(),
+		const TspOptions &options = {},
+		const std::vector<size_t> &initial_tour = {});
+
+/**
+ * Same as tsp_open_end, but with the distances given as rows (see DistanceHeuristics::between_distance_rows).
+ */
+std::vector<size_t> tsp_open_end_rows(
+		const std::vector<double> &from_start,
+		const std::function<void(size_t, double *)> &between_rows,
+		const ompl::base::PlannerTerminationCondition &ptc = ompl::base::plannerNonTerminatingCondition(),
+		const TspOptions &options = {},
+		const std::vector<size_t> &initial_tour = {});
+
+/**
+ * Open-ended TSP over a k-nearest-neighbour candidate graph of the given positions (see sparse_tsp.h),
+ * with k = options.sparse_neighbours. `between` is only evaluated on candidate edges.
+ *
+ * This always uses the built-in local search; options.solver is ignored.
+ */
+std::vector<size_t> tsp_open_end_sparse(
+		const Eigen::Vector3d &start_position,
+		const std::vector<Eigen::Vector3d> &positions,
+		const std::function<double(size_t)> &from_start,
+		const std::function<double(size_t, size_t)> &between,
+		const ompl::base::PlannerTerminationCondition &ptc = ompl::base::plannerNonTerminatingCondition(),
+		const TspOptions &options = {});
+
+/**
+ * Cluster-then-route open-ended TSP, for goal sets too large to route in one go.
+ *
+ * The items are clustered with k-medoids into clusters of about options.cluster_size, the medoids are routed,
+ * and then every cluster is routed separately (in parallel if options.parallel_distances is set),
+ * entering from the previous cluster's medoid. Finally, the tour is smoothed with 2-opt around every boundary
+ * between clusters.
+ *
+ * Solver time and memory are bounded by the cluster size, at the cost of a somewhat longer tour.
+ *
+ * @param initial_tour 	Warm start; only used if the problem is small enough to not be clustered.
+ */
+std::vector<size_t> tsp_open_end_hierarchical(
+		const std::function<double(size_t)> &from_start,
+		const std::function<double(size_t, size_t)> &between,
+		size_t n,
+		const ompl::base::PlannerTerminationCondition &ptc = ompl::base::plannerNonTerminatingCondition(),
+		const TspOptions &options = {},
+		const std::vector<size_t> &initial_tour = {});
 
 std::vector<std::pair<size_t, size_t>>
 tsp_open_end_grouped(const std::function<double(std::pair<size_t, size_t>)> &from_start,
 					 const std::function<double(std::pair<size_t, size_t>, std::pair<size_t, size_t>)> &between,
 					 const std::vector<size_t> &sizes,
-					 ompl::base::PlannerTerminationCondition &ptc);
+					 ompl::base::PlannerTerminationCondition &ptc,
+					 const TspOptions &options = {});
+
+/**
+ * Same as tsp_open_end_grouped, but using solve_open_tsp_lazy: `between` is only evaluated for edges
+ * that appear in a candidate tour, with between_lower_bound used for everything else.
+ */
+std::vector<std::pair<size_t, size_t>>
+tsp_open_end_grouped_lazy(const std::function<double(std::pair<size_t, size_t>)> &from_start,
+						  const std::function<double(std::pair<size_t, size_t>, std::pair<size_t, size_t>)> &between,
+						  const std::function<double(std::pair<size_t, size_t>, std::pair<size_t, size_t>)> &between_lower_bound,
+						  const std::vector<size_t> &sizes,
+						  ompl::base::PlannerTerminationCondition &ptc,
+						  const TspOptions &options = {});
 
 #endif //NEW_PLANNERS_TRAVELING_SALESMAN_H
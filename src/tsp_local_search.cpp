@@ -0,0 +1,382 @@
+
+#include "tsp_local_search.h"
+#include "general_utilities.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <execution>
+#include <numeric>
+
+namespace {
+
+	/// Stand-in for "no next node", at the open end of the tour. Distances to it are zero.
+	constexpr size_t NO_NODE = std::numeric_limits<size_t>::max();
+
+	/// Moves must improve the tour by at least this much, to avoid cycling on rounding errors.
+	constexpr double IMPROVEMENT_EPSILON = 1.0e-9;
+
+	/// Replaces infinite distances, such that the deltas computed in the local search stay finite.
+	constexpr double UNREACHABLE_DISTANCE = 1.0e9;
+
+	/**
+	 * Local search moves, applied in-place to a tour.
+	 */
+	class OpenTourSearch {
+
+		const GroupedOpenTsp &problem;
+		std::vector<size_t> &tour;
+
+		[[nodiscard]] double d(size_t a, size_t b) const {
+			return b == NO_NODE ? 0.0 : problem.distance(a, b);
+		}
+
+		[[nodiscard]] size_t before(size_t position) const {
+			return position == 0 ? problem.start() : tour[position - 1];
+		}
+
+		[[nodiscard]] size_t after(size_t position) const {
+			return position + 1 < tour.size() ? tour[position + 1] : NO_NODE;
+		}
+
+	public:
+		OpenTourSearch(const GroupedOpenTsp &problem, std::vector<size_t> &tour) : problem(problem), tour(tour) {
+		}
+
+		/// Reverse sub-sequences of the tour wherever that makes it shorter.
+		bool twoOpt(const ompl::base::PlannerTerminationCondition &ptc) {
+
+			bool improved = false;
+
+			for (size_t i = 0; i + 1 < tour.size() && !ptc(); ++i) {
+				for (size_t j = i + 1; j < tour.size(); ++j) {
+
+					size_t a = before(i), b = tour[i], c = tour[j], e = after(j);
+
+					double delta = d(a, c) + d(b, e) - d(a, b) - d(c, e);
+
+					if (delta < -IMPROVEMENT_EPSILON) {
+						std::reverse(tour.begin() + (long) i, tour.begin() + (long) j + 1);
+						improved = true;
+					}
+				}
+			}
+
+			return improved;
+		}
+
+		/// Move segments of up to three nodes (possibly reversed) to a better position in the tour.
+		bool orOpt(const ompl::base::PlannerTerminationCondition &ptc) {
+
+			bool improved = false;
+
+			for (size_t length = 1; length <= 3; ++length) {
+				for (size_t i = 0; i + length <= tour.size() && !ptc(); ++i) {
+
+					size_t first = tour[i], last = tour[i + length - 1];
+					size_t prev = before(i), next = after(i + length - 1);
+
+					double removal_gain = d(prev, first) + d(last, next) - d(prev, next);
+
+					double best_delta = -IMPROVEMENT_EPSILON;
+					size_t best_k = NO_NODE;
+					bool best_reversed = false;
+
+					// Insert between tour[k-1] (or the start) and tour[k] (or the open end).
+					for (size_t k = 0; k <= tour.size(); ++k) {
+
+						if (k >= i && k <= i + length) {
+							continue;
+						}
+
+						size_t a = before(k), b = k < tour.size() ? tour[k] : NO_NODE;
+
+						double forward = d(a, first) + d(last, b) - d(a, b) - removal_gain;
+						double reversed = d(a, last) + d(first, b) - d(a, b) - removal_gain;
+
+						if (forward < best_delta) {
+							best_delta = forward;
+							best_k = k;
+							best_reversed = false;
+						}
+						if (reversed < best_delta) {
+							best_delta = reversed;
+							best_k = k;
+							best_reversed = true;
+						}
+					}
+
+					if (best_k != NO_NODE) {
+
+						std::vector<size_t> segment(tour.begin() + (long) i, tour.begin() + (long) (i + length));
+						if (best_reversed) {
+							std::reverse(segment.begin(), segment.end());
+						}
+
+						tour.erase(tour.begin() + (long) i, tour.begin() + (long) (i + length));
+
+						size_t insert_at = best_k > i ? best_k - length : best_k;
+						tour.insert(tour.begin() + (long) insert_at, segment.begin(), segment.end());
+
+						improved = true;
+					}
+				}
+			}
+
+			return improved;
+		}
+
+		/// For every visited group, switch to the member that is cheapest given its neighbours in the tour.
+		bool reselectMembers() {
+
+			bool improved = false;
+
+			for (size_t position = 0; position < tour.size(); ++position) {
+
+				const auto &members = problem.group_members[problem.group_of[tour[position]]];
+
+				if (members.size() < 2) {
+					continue;
+				}
+
+				size_t prev = before(position), next = after(position);
+
+				double current_cost = d(prev, tour[position]) + d(tour[position], next);
+
+				for (size_t member: members) {
+					double cost = d(prev, member) + d(member, next);
+					if (cost < current_cost - IMPROVEMENT_EPSILON) {
+						current_cost = cost;
+						tour[position] = member;
+						improved = true;
+					}
+				}
+			}
+
+			return improved;
+		}
+	};
+
+	/// A problem with the given group sizes, and an all-zero distance matrix.
+	GroupedOpenTsp problem_with_groups(const std::vector<size_t> &sizes) {
+
+		GroupedOpenTsp problem;
+
+		for (size_t group = 0; group < sizes.size(); ++group) {
+			problem.group_members.emplace_back();
+			for (size_t member = 0; member < sizes[group]; ++member) {
+				problem.group_members.back().push_back(problem.n++);
+				problem.group_of.push_back(group);
+			}
+		}
+
+		problem.distances = PackedSymmetricMatrix<float>(problem.n + 1);
+
+		return problem;
+	}
+
+	/// Call fill_row for every row index in [0, n), in parallel if requested. Throws PlanningTimeout if the ptc triggers.
+	void for_each_row(size_t n,
+					  bool parallel,
+					  const ompl::base::PlannerTerminationCondition &ptc,
+					  const std::function<void(size_t)> &fill_row) {
+
+		if (!parallel) {
+			for (size_t i = 0; i < n; ++i) {
+				fill_row(i);
+				checkPtc(ptc);
+			}
+			return;
+		}
+
+		std::vector<size_t> rows(n);
+		std::iota(rows.begin(), rows.end(), 0);
+
+		// Exceptions escaping a parallel algorithm call std::terminate, so a timeout is signalled through a flag instead.
+		std::atomic<bool> timed_out{false};
+
+		std::for_each(std::execution::par, rows.begin(), rows.end(), [&](size_t i) {
+			if (timed_out.load(std::memory_order_relaxed)) {
+				return;
+			}
+			if (ptc()) {
+				timed_out = true;
+				return;
+			}
+			fill_row(i);
+		});
+
+		if (timed_out) {
+			throw PlanningTimeout();
+		}
+	}
+
+	/// Greedily go to the nearest node of a group that has not been visited yet.
+	std::vector<size_t> nearest_neighbour_tour(const GroupedOpenTsp &problem) {
+
+		std::vector<bool> group_visited(problem.group_members.size(), false);
+
+		// Empty groups can't be visited, so don't count them.
+		const size_t groups_to_visit = std::count_if(problem.group_members.begin(), problem.group_members.end(), [](const auto &members) {
+			return !members.empty();
+		});
+
+		std::vector<size_t> tour;
+		tour.reserve(groups_to_visit);
+
+		size_t current = problem.start();
+
+		while (tour.size() < groups_to_visit) {
+
+			size_t nearest = NO_NODE;
+			double nearest_distance = std::numeric_limits<double>::infinity();
+
+			for (size_t node = 0; node < problem.n; ++node) {
+				if (!group_visited[problem.group_of[node]] &&
+					(nearest == NO_NODE || problem.distance(current, node) < nearest_distance)) {
+					nearest = node;
+					nearest_distance = problem.distance(current, node);
+				}
+			}
+
+			group_visited[problem.group_of[nearest]] = true;
+			tour.push_back(nearest);
+			current = nearest;
+		}
+
+		return tour;
+	}
+
+}
+
+GroupedOpenTsp GroupedOpenTsp::build(const std::function<double(size_t)> &from_start,
+									 const std::function<double(size_t, size_t)> &between,
+									 const std::vector<size_t> &sizes,
+									 const ompl::base::PlannerTerminationCondition &ptc,
+									 bool parallel) {
+
+	auto problem = problem_with_groups(sizes);
+
+	// Every row only fills in the pairs (i, j > i) and their mirror image, so rows never write the same entry.
+	for_each_row(problem.n, parallel, ptc, [&](size_t i) {
+		for (size_t j = i + 1; j < problem.n; ++j) {
+			problem.setDistance(i, j, between(i, j));
+		}
+		problem.setDistance(i, problem.start(), from_start(i));
+	});
+
+	return problem;
+}
+
+GroupedOpenTsp GroupedOpenTsp::buildFromRows(const std::vector<double> &from_start,
+											 const std::function<void(size_t, double *)> &row,
+											 const std::vector<size_t> &sizes,
+											 const ompl::base::PlannerTerminationCondition &ptc,
+											 bool parallel) {
+
+	auto problem = problem_with_groups(sizes);
+
+	for_each_row(problem.n, parallel, ptc, [&](size_t i) {
+
+		std::vector<double> row_distances(problem.n);
+		row(i, row_distances.data());
+
+		// As in build(), only the entries (i, j > i) belong to this row.
+		for (size_t j = i + 1; j < problem.n; ++j) {
+			problem.setDistance(i, j, row_distances[j]);
+		}
+
+		problem.setDistance(i, problem.start(), from_start[i]);
+	});
+
+	return problem;
+}
+
+void GroupedOpenTsp::setDistance(size_t i, size_t j, double d) {
+	distances.set(i, j, (float) (std::isfinite(d) ? d : UNREACHABLE_DISTANCE));
+}
+
+double open_tour_length(const GroupedOpenTsp &problem, const std::vector<size_t> &tour) {
+
+	double length = 0.0;
+	size_t current = problem.start();
+
+	for (size_t node: tour) {
+		length += problem.distance(current, node);
+		current = node;
+	}
+
+	return length;
+}
+
+std::vector<size_t> repair_tour(const GroupedOpenTsp &problem, const std::vector<size_t> &tour) {
+
+	std::vector<bool> group_visited(problem.group_members.size(), false);
+
+	std::vector<size_t> repaired;
+	repaired.reserve(problem.group_members.size());
+
+	for (size_t node: tour) {
+		if (node < problem.n && !group_visited[problem.group_of[node]]) {
+			group_visited[problem.group_of[node]] = true;
+			repaired.push_back(node);
+		}
+	}
+
+	for (size_t group = 0; group < problem.group_members.size(); ++group) {
+
+		if (group_visited[group] || problem.group_members[group].empty()) {
+			continue;
+		}
+
+		// Cheapest insertion, over all members of the group and all positions.
+		size_t best_member = problem.group_members[group].front(), best_position = 0;
+		double best_increase = std::numeric_limits<double>::infinity();
+
+		for (size_t member: problem.group_members[group]) {
+			for (size_t position = 0; position <= repaired.size(); ++position) {
+
+				size_t before = position == 0 ? problem.start() : repaired[position - 1];
+
+				double increase = problem.distance(before, member);
+				if (position < repaired.size()) {
+					increase += problem.distance(member, repaired[position]) - problem.distance(before, repaired[position]);
+				}
+
+				if (increase < best_increase) {
+					best_increase = increase;
+					best_member = member;
+					best_position = position;
+				}
+			}
+		}
+
+		repaired.insert(repaired.begin() + (long) best_position, best_member);
+		group_visited[group] = true;
+	}
+
+	return repaired;
+}
+
+std::vector<size_t> solve_open_tsp_local_search(const GroupedOpenTsp &problem,
+												const ompl::base::PlannerTerminationCondition &ptc,
+												const std::vector<size_t> &initial_tour) {
+
+	auto tour = initial_tour.empty() ? nearest_neighbour_tour(problem) : repair_tour(problem, initial_tour);
+
+	OpenTourSearch search(problem, tour);
+
+	while (!ptc()) {
+
+		bool improved = search.twoOpt(ptc);
+		improved |= search.orOpt(ptc);
+		improved |= search.reselectMembers();
+
+		if (!improved) {
+			break;
+		}
+	}
+
+	return tour;
+}
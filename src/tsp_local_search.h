@@ -0,0 +1,107 @@
+#ifndef NEW_PLANNERS_TSP_LOCAL_SEARCH_H
+#define NEW_PLANNERS_TSP_LOCAL_SEARCH_H
+
+#include <vector>
+#include <functional>
+#include <ompl/base/PlannerTerminationCondition.h>
+#include "PackedSymmetricMatrix.h"
+
+/**
+ * An open-ended traveling salesman problem with groups: starting from a fixed start node,
+ * visit exactly one node out of every group, and end anywhere.
+ *
+ * The plain open-ended TSP is the special case where every group consists of a single node.
+ *
+ * Distances are assumed to be symmetric.
+ */
+struct GroupedOpenTsp {
+
+	/// Number of nodes, not counting the start node.
+	size_t n = 0;
+
+	/// The group of every node.
+	std::vector<size_t> group_of;
+
+	/// The nodes in every group.
+	std::vector<std::vector<size_t>> group_members;
+
+	/// Distances between all nodes, where index n is the start node. Packed and single-precision,
+	/// since for grouped problems n is the total number of goal samples, which gets large quickly.
+	PackedSymmetricMatrix<float> distances;
+
+	[[nodiscard]] size_t start() const {
+		return n;
+	}
+
+	[[nodiscard]] double distance(size_t i, size_t j) const {
+		return distances(i, j);
+	}
+
+	/// Set the (symmetric) distance between two nodes, replacing a non-finite distance by a large finite penalty.
+	void setDistance(size_t i, size_t j, double d);
+
+	/**
+	 * Build the problem by evaluating all distances.
+	 *
+	 * Nodes are numbered group by group: the nodes of group 0 first, then those of group 1, etc.
+	 *
+	 * @param from_start 	Distance from the start to the given node.
+	 * @param between 		Distance between two nodes.
+	 * @param sizes 		The number of nodes in every group.
+	 * @param ptc 			Checked before/after every row of the matrix; throws PlanningTimeout if it triggers.
+	 * @param parallel 		Whether to evaluate rows in parallel; only if both callbacks are thread-safe and don't throw.
+	 */
+	static GroupedOpenTsp build(const std::function<double(size_t)> &from_start,
+								const std::function<double(size_t, size_t)> &between,
+								const std::vector<size_t> &sizes,
+								const ompl::base::PlannerTerminationCondition &ptc,
+								bool parallel = false);
+
+	/**
+	 * Build the problem from a function that computes an entire row of the matrix at once,
+	 * such as the batched kernels in distance_kernels.h.
+	 *
+	 * @param from_start 	Distance from the start to every node.
+	 * @param row 			Given a node i, writes the distances from i to all n nodes into the output array.
+	 * 						Only the entries for nodes after i are used.
+	 * @param sizes 		The number of nodes in every group.
+	 * @param ptc 			See build().
+	 * @param parallel 		See build(); applies to the row function.
+	 */
+	static GroupedOpenTsp buildFromRows(const std::vector<double> &from_start,
+										const std::function<void(size_t, double *)> &row,
+										const std::vector<size_t> &sizes,
+										const ompl::base::PlannerTerminationCondition &ptc,
+										bool parallel = false);
+};
+
+/**
+ * Length of an open tour through the given nodes, starting at the start node.
+ */
+double open_tour_length(const GroupedOpenTsp &problem, const std::vector<size_t> &tour);
+
+/**
+ * Solve the problem using a nearest-neighbour construction, followed by 2-opt, Or-opt and
+ * group member re-selection moves until a local optimum is reached.
+ *
+ * Every move strictly improves the tour, so if the ptc triggers, the search simply stops
+ * and returns the best tour found so far.
+ *
+ * @param initial_tour 	Tour to start the search from (a warm start), passed through repair_tour; if empty,
+ * 						a nearest-neighbour tour is used instead.
+ * @return The visited nodes, in order; exactly one per group.
+ */
+std::vector<size_t> solve_open_tsp_local_search(const GroupedOpenTsp &problem,
+												const ompl::base::PlannerTerminationCondition &ptc,
+												const std::vector<size_t> &initial_tour = {});
+
+/**
+ * Turn a sequence of nodes into a valid tour: nodes that don't exist or whose group was already visited are dropped,
+ * and groups that are not visited at all get the member and position that increase the tour length the least.
+ *
+ * This allows a tour for a slightly different problem (say, from before some goals were added or removed)
+ * to be used as a warm start.
+ */
+std::vector<size_t> repair_tour(const GroupedOpenTsp &problem, const std::vector<size_t> &tour);
+
+#endif //NEW_PLANNERS_TSP_LOCAL_SEARCH_H
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+
+#include "../src/UnionGoalSampleableRegion.h"
+
+/// A goal that always samples the same one-dimensional state.
+class ConstantGoal : public ompl::base::GoalSampleableRegion {
+
+    double value;
+
+public:
+    ConstantGoal(const ompl::base::SpaceInformationPtr &si, double value) : GoalSampleableRegion(si), value(value) {}
+
+    void sampleGoal(ompl::base::State *st) const override {
+        st->as<ompl::base::RealVectorStateSpace::StateType>()->values[0] = value;
+    }
+
+    [[nodiscard]] unsigned int maxSampleCount() const override {
+        return 1;
+    }
+
+    double distanceGoal(const ompl::base::State *st) const override {
+        return std::abs(st->as<ompl::base::RealVectorStateSpace::StateType>()->values[0] - value);
+    }
+};
+
+/// A one-dimensional space in which the positive states are valid.
+ompl::base::SpaceInformationPtr positiveIsValid() {
+
+    auto space = std::make_shared<ompl::base::RealVectorStateSpace>(1);
+    space->setBounds(-10.0, 10.0);
+
+    auto si = std::make_shared<ompl::base::SpaceInformation>(space);
+    si->setStateValidityChecker([](const ompl::base::State *st) {
+        return st->as<ompl::base::RealVectorStateSpace::StateType>()->values[0] > 0.0;
+    });
+    si->setup();
+
+    return si;
+}
+
+TEST(AdaptiveUnionGoalTest, prefers_sub_goals_with_valid_samples) {
+
+    auto si = positiveIsValid();
+
+    AdaptiveUnionGoalSampleableRegion goal(si, {
+            std::make_shared<ConstantGoal>(si, 1.0),
+            std::make_shared<ConstantGoal>(si, -1.0)
+    });
+
+    ompl::base::ScopedState<> st(si);
+    for (size_t i = 0; i < 200; ++i) {
+        goal.sampleGoal(st.get());
+    }
+
+    auto stats = goal.getStatistics();
+
+    EXPECT_DOUBLE_EQ(stats[0]["yield"].asDouble(), 1.0);
+    EXPECT_DOUBLE_EQ(stats[1]["yield"].asDouble(), 0.0);
+
+    // UCB1 keeps exploring the unproductive sub-goal, but only about logarithmically often.
+    EXPECT_GE(stats[1]["samples"].asUInt64(), 1);
+    EXPECT_LT(stats[1]["samples"].asUInt64(), 30);
+    EXPECT_EQ(stats[0]["samples"].asUInt64() + stats[1]["samples"].asUInt64(), 200);
+}
+
+TEST(AdaptiveUnionGoalTest, avoids_sub_goals_that_fail_to_connect) {
+
+    auto si = positiveIsValid();
+
+    AdaptiveUnionGoalSampleableRegion goal(si, {
+            std::make_shared<ConstantGoal>(si, 1.0),
+            std::make_shared<ConstantGoal>(si, 2.0)
+    });
+
+    ompl::base::ScopedState<> st(si);
+    for (size_t i = 0; i < 200; ++i) {
+        goal.sampleGoal(st.get());
+
+        // Samples of the first sub-goal never connect; the second one never reports.
+        if (st->as<ompl::base::RealVectorStateSpace::StateType>()->values[0] == 1.0) {
+            goal.reportConnection(st.get(), false);
+        }
+    }
+
+    auto stats = goal.getStatistics();
+
+    EXPECT_DOUBLE_EQ(stats[0]["connection_rate"].asDouble(), 0.0);
+    EXPECT_GT(stats[1]["samples"].asUInt64(), 3 * stats[0]["samples"].asUInt64());
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <random>
+
+#include "../src/experiment_utils.h"
+#include "../src/DroneStateView.h"
+#include "../src/InformedBetweenTwoDroneStatesSampler.h"
+
+/// Whether the short way from q to b around an angle passes the far side as seen from a (see DroneInformedSubset).
+bool wrapsAround(double a, double b, double q) {
+    return std::abs(std::remainder(q - a, 2.0 * M_PI) - std::remainder(b - a, 2.0 * M_PI)) > M_PI;
+}
+
+TEST(DroneInformedSubsetTest, informed_subset_within_hyperspheroid) {
+
+    auto robot = loadRobotModel();
+    ompl_interface::ModelBasedStateSpaceSpecification spec(robot, "whole_body");
+    auto state_space = std::make_shared<DroneStateSpace>(spec);
+    auto si = std::make_shared<ompl::base::SpaceInformation>(state_space);
+
+    auto sampler = state_space->allocDefaultStateSampler();
+
+    ompl::base::ScopedState<> a(state_space), b(state_space), q(state_space);
+
+    std::mt19937 rng(42);
+    std::normal_distribution<double> offset(0.0, 0.2);
+
+    size_t checked = 0;
+
+    for (size_t pair = 0; pair < 100; ++pair) {
+
+        sampler->sampleUniform(a.get());
+        sampler->sampleUniform(b.get());
+
+        DroneStateView view_a(*state_space, a.get()), view_b(*state_space, b.get());
+
+        // Keep the bases close together, such that the angles make up a large part of the distance.
+        const Eigen::Vector3d position = view_a.basePosition();
+        view_b.setBasePosition(position + Eigen::Vector3d(offset(rng), offset(rng), offset(rng)));
+
+        DroneInformedSubset subset(si, a.get(), b.get());
+
+        for (size_t i = 0; i < 100; ++i) {
+
+            sampler->sampleUniform(q.get());
+
+            DroneStateView view_q(*state_space, q.get());
+            view_q.setBasePosition(position + Eigen::Vector3d(offset(rng), offset(rng), offset(rng)));
+
+            bool wraps = wrapsAround(view_a.yaw(), view_b.yaw(), view_q.yaw());
+            for (size_t j = 0; j < view_q.armJointCount(); ++j) {
+                if (!view_q.armJointBounds(j).position_bounded_) {
+                    wraps |= wrapsAround(view_a.armJoint(j), view_b.armJoint(j), view_q.armJoint(j));
+                }
+            }
+
+            if (wraps) {
+                continue;
+            }
+
+            const double cost = state_space->distance(a.get(), q.get()) + state_space->distance(q.get(), b.get());
+
+            // d(a, q) + d(q, b) <= c implies that q is in the hyperspheroid with transverse diameter c.
+            EXPECT_LE(subset.coordinateCost(q.get()), cost + 1.0e-6);
+
+            ++checked;
+        }
+
+        // The foci themselves are in the smallest hyperspheroid.
+        EXPECT_LE(subset.coordinateCost(a.get()), subset.getFocusDistance() + 1.0e-6);
+        EXPECT_LE(subset.coordinateCost(b.get()), subset.getFocusDistance() + 1.0e-6);
+    }
+
+    EXPECT_GT(checked, 0);
+}
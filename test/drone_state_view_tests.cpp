@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include <ompl/base/ScopedState.h>
+
+#include "../src/experiment_utils.h"
+#include "../src/DroneStateView.h"
+
+TEST(DroneStateViewTest, set_base_position_on_uninitialized_state) {
+
+    auto robot = loadRobotModel();
+    ompl_interface::ModelBasedStateSpaceSpecification spec(robot, "whole_body");
+    auto state_space = std::make_shared<DroneStateSpace>(spec);
+
+    auto *state = state_space->allocState();
+
+    // Freshly allocated states hold whatever was in memory; make that as hostile as possible.
+    double *values = state->as<DroneStateSpace::StateType>()->values;
+    std::fill(values, values + state_space->getJointModelGroup()->getVariableCount(),
+              std::numeric_limits<double>::quiet_NaN());
+
+    DroneStateView view(*state_space, state);
+
+    const Eigen::Vector3d position(1.0, -2.0, 3.0);
+    view.setBasePosition(position);
+
+    EXPECT_EQ(view.basePosition(), position);
+
+    state_space->freeState(state);
+}
+
+TEST(DroneStateViewTest, cached_link_transforms_match_forward_kinematics) {
+
+    auto robot = loadRobotModel();
+    ompl_interface::ModelBasedStateSpaceSpecification spec(robot, "whole_body");
+    auto state_space = std::make_shared<DroneStateSpace>(spec);
+
+    ompl::base::ScopedState<> state(state_space);
+    state_space->allocDefaultStateSampler()->sampleUniform(state.get());
+
+    DroneStateView view(*state_space, state.get());
+
+    moveit::core::RobotState fresh(robot);
+
+    // Compare every link against forward kinematics from scratch.
+    auto expect_consistent = [&](const std::string &after) {
+        state_space->copyToRobotState(fresh, state.get());
+        fresh.update(true);
+
+        for (const auto &link: robot->getLinkModelNames()) {
+            EXPECT_TRUE(view.linkTransform(link).isApprox(fresh.getGlobalLinkTransform(link), 1e-9))
+                                << "link " << link << " after " << after;
+        }
+    };
+
+    expect_consistent("sampling");
+
+    view.translateBase({0.5, -1.0, 0.25});
+    expect_consistent("translateBase");
+
+    view.setBasePosition({3.0, 2.0, 1.0});
+    expect_consistent("setBasePosition");
+
+    view.setYaw(1.2);
+    expect_consistent("setYaw");
+
+    view.translateBase({-0.3, 0.1, 0.0});
+    expect_consistent("translateBase after setYaw");
+
+    for (size_t i = 0; i < view.armJointCount(); ++i) {
+        const auto &bounds = view.armJointBounds(i);
+        view.setArmJoint(i, bounds.position_bounded_ ? (bounds.min_position_ + bounds.max_position_) / 2.0 : 0.5);
+        expect_consistent("setArmJoint " + std::to_string(i));
+    }
+
+    view.setBasePosition({-1.0, 0.0, 4.0});
+    expect_consistent("setBasePosition after setArmJoint");
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "../src/experiment_utils.h"
+#include "../src/GoalStatePool.h"
+
+ompl::base::SpaceInformationPtr spaceInformationWithValidity(bool valid) {
+
+    auto robot = loadRobotModel();
+    ompl_interface::ModelBasedStateSpaceSpecification spec(robot, "whole_body");
+    auto si = std::make_shared<ompl::base::SpaceInformation>(std::make_shared<DroneStateSpace>(spec));
+
+    si->setStateValidityChecker([valid](const ompl::base::State *) { return valid; });
+    si->setup();
+
+    return si;
+}
+
+TEST(GoalStatePoolTest, take_from_filled_pool) {
+
+    auto si = spaceInformationWithValidity(true);
+
+    auto goal = std::make_shared<DroneEndEffectorNearTarget>(si, 0.05, Eigen::Vector3d(1.0, 2.0, 3.0));
+
+    auto pool = std::make_shared<GoalStatePool>();
+    pool->fill({goal}, 10, 2);
+
+    ASSERT_EQ(pool->available(goal->getTarget()), 10);
+
+    goal->setStatePool(pool);
+
+    ompl::base::ScopedState<> state(si);
+
+    for (size_t i = 0; i < 10; ++i) {
+        ASSERT_TRUE(goal->samplePooled(state.get()));
+        EXPECT_TRUE(goal->isSatisfied(state.get()));
+        EXPECT_EQ(pool->available(goal->getTarget()), 9 - i);
+    }
+
+    // Empty now; sampleGoal falls back to sampling live.
+    EXPECT_FALSE(goal->samplePooled(state.get()));
+    goal->sampleGoal(state.get());
+    EXPECT_TRUE(goal->isSatisfied(state.get()));
+
+    auto stats = pool->statistics();
+    EXPECT_EQ(stats["served"].asUInt64(), 10);
+    EXPECT_EQ(stats["missed"].asUInt64(), 2);
+    EXPECT_EQ(stats["available"].asUInt64(), 0);
+}
+
+TEST(GoalStatePoolTest, fill_drops_failed_samples) {
+
+    auto si = spaceInformationWithValidity(false);
+
+    auto goal = std::make_shared<DroneEndEffectorNearTarget>(si, 0.05, Eigen::Vector3d(1.0, 2.0, 3.0));
+
+    GoalStatePool pool;
+    pool.fill({goal}, 3, 1);
+
+    EXPECT_EQ(pool.available(goal->getTarget()), 0);
+}
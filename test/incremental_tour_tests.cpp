@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <Eigen/Core>
+
+#include "../src/planners/IncrementalTour.h"
+
+/// Euclidean distances between points, with a start that can be moved; goal IDs index into the points.
+struct PointsTour {
+    Eigen::Vector3d start = Eigen::Vector3d::Zero();
+    std::vector<Eigen::Vector3d> points;
+
+    IncrementalTour tour{
+            [this](size_t goal) { return (points[goal] - start).norm(); },
+            [this](size_t a, size_t b) { return (points[a] - points[b]).norm(); }
+    };
+
+    explicit PointsTour(std::vector<Eigen::Vector3d> points) : points(std::move(points)) {}
+};
+
+std::vector<Eigen::Vector3d> on_x_axis(const std::vector<double> &xs) {
+    std::vector<Eigen::Vector3d> points;
+    for (double x : xs) {
+        points.emplace_back(x, 0.0, 0.0);
+    }
+    return points;
+}
+
+TEST(IncrementalTourTest, insertion_on_a_line) {
+
+    PointsTour pt(on_x_axis({1.0, 2.0, 3.0, 4.0}));
+
+    for (size_t goal : {2, 0, 3, 1}) {
+        pt.tour.insertCheapest(goal);
+    }
+
+    EXPECT_EQ(pt.tour.getOrder(), std::vector<size_t>({0, 1, 2, 3}));
+    EXPECT_DOUBLE_EQ(pt.tour.predictedLength(), 4.0);
+}
+
+TEST(IncrementalTourTest, removal_keeps_the_order) {
+
+    PointsTour pt(on_x_axis({1.0, 2.0, 3.0, 4.0, 5.0}));
+
+    for (size_t goal = 0; goal < pt.points.size(); ++goal) {
+        pt.tour.insertCheapest(goal);
+    }
+
+    pt.tour.remove(2);
+    pt.tour.remove(0);
+    pt.tour.remove(42); // Unknown; ignored.
+
+    EXPECT_EQ(pt.tour.getOrder(), std::vector<size_t>({1, 3, 4}));
+    EXPECT_FALSE(pt.tour.contains(2));
+
+    // Re-adding goes back to the same spot.
+    pt.tour.insertCheapest(2);
+    EXPECT_EQ(pt.tour.getOrder(), std::vector<size_t>({1, 2, 3, 4}));
+}
+
+TEST(IncrementalTourTest, start_change_reverses_the_prefix) {
+
+    PointsTour pt(on_x_axis({1.0, 2.0, 3.0, 4.0}));
+
+    for (size_t goal = 0; goal < pt.points.size(); ++goal) {
+        pt.tour.insertCheapest(goal);
+    }
+
+    // From the far end, the tour is best walked the other way around.
+    pt.start = {5.0, 0.0, 0.0};
+    pt.tour.repairStart();
+
+    EXPECT_EQ(pt.tour.getOrder(), std::vector<size_t>({3, 2, 1, 0}));
+
+    // Nothing to gain when the start moves back in the middle of the first stretch.
+    pt.start = {4.5, 0.0, 0.0};
+    pt.tour.repairStart();
+
+    EXPECT_EQ(pt.tour.getOrder(), std::vector<size_t>({3, 2, 1, 0}));
+}
+
+TEST(IncrementalTourTest, improvement_never_lengthens_the_tour) {
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coordinate(0.0, 10.0);
+
+    std::vector<Eigen::Vector3d> points(30);
+    for (auto &point : points) {
+        point = {coordinate(rng), coordinate(rng), 0.0};
+    }
+
+    PointsTour pt(points);
+
+    for (size_t goal = 0; goal < pt.points.size(); ++goal) {
+        pt.tour.insertCheapest(goal);
+    }
+
+    const double inserted = pt.tour.predictedLength();
+
+    pt.tour.improve(ompl::base::plannerNonTerminatingCondition());
+
+    EXPECT_LE(pt.tour.predictedLength(), inserted + 1e-9);
+
+    auto sorted = pt.tour.getOrder();
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t goal = 0; goal < points.size(); ++goal) {
+        EXPECT_EQ(sorted[goal], goal);
+    }
+}
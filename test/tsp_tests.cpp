@@ -1,9 +1,13 @@
 
 #include <gtest/gtest.h>
+#include <random>
 #include <range/v3/all.hpp>
 #include <ortools/constraint_solver/routing_index_manager.h>
 #include <ortools/constraint_solver/routing.h>
 #include <ortools/constraint_solver/routing_parameters.h>
+#include "../src/TspMemo.h"
+#include "../src/traveling_salesman.h"
+#include "../src/general_utilities.h"
 
 TEST(TSPTEST, grouped_tsp) {
 
@@ -46,3 +50,300 @@ TEST(TSPTEST, grouped_tsp) {
 
 
 }
+
+TEST(TSPTEST, local_search_points_on_a_line) {
+
+    const std::vector<double> points = {4.0, 1.0, 3.0, 2.0, 5.0};
+
+    // Small enough for the exact solver, which would otherwise take over.
+    TspOptions options {TspSolver::LOCAL_SEARCH};
+    options.exact_threshold = 0;
+
+    auto ordering = tsp_open_end([&](size_t i) {
+        return std::abs(points[i]);
+    }, [&](size_t i, size_t j) {
+        return std::abs(points[i] - points[j]);
+    }, points.size(), ompl::base::plannerNonTerminatingCondition(), options);
+
+    EXPECT_EQ(ordering, std::vector<size_t>({1, 3, 2, 0, 4}));
+}
+
+TEST(TSPTEST, local_search_grouped_visits_each_group_once) {
+
+    // Two groups on a line, with the best member of each being the one closest to the start.
+    const std::vector<std::vector<double>> groups = {{3.0, 8.0}, {-1.0, 1.0, 6.0}};
+
+    auto ptc = ompl::base::plannerNonTerminatingCondition();
+
+    TspOptions options {TspSolver::LOCAL_SEARCH};
+    options.exact_threshold = 0;
+
+    auto ordering = tsp_open_end_grouped([&](auto i) {
+        return std::abs(groups[i.first][i.second]);
+    }, [&](auto i, auto j) {
+        return std::abs(groups[i.first][i.second] - groups[j.first][j.second]);
+    }, {2, 3}, ptc, options);
+
+    ASSERT_EQ(ordering.size(), 2);
+    EXPECT_EQ(ordering[0], std::make_pair<size_t, size_t>(1, 1));
+    EXPECT_EQ(ordering[1], std::make_pair<size_t, size_t>(0, 0));
+}
+
+TEST(TSPTEST, warm_start_after_removing_and_adding_points) {
+
+    const std::vector<double> points = {4.0, 1.0, 3.0, 2.0, 5.0};
+
+    auto problem = GroupedOpenTsp::build([&](size_t i) {
+        return std::abs(points[i]);
+    }, [&](size_t i, size_t j) {
+        return std::abs(points[i] - points[j]);
+    }, std::vector<size_t>(points.size(), 1), ompl::base::plannerNonTerminatingCondition());
+
+    // A tour from before point 4 was added, with a point 7 that has since been removed.
+    auto repaired = repair_tour(problem, {1, 7, 3, 2, 0});
+    EXPECT_EQ(repaired, std::vector<size_t>({1, 3, 2, 0, 4}));
+
+    auto ordering = solve_open_tsp_local_search(problem, ompl::base::plannerNonTerminatingCondition(), {4, 0, 2, 3, 1});
+    EXPECT_EQ(ordering, std::vector<size_t>({1, 3, 2, 0, 4}));
+}
+
+TEST(TSPTEST, lazy_grouped_evaluates_few_distances) {
+
+    const std::vector<double> points = {7.0, 2.0, 5.0, 1.0, 8.0, 3.0, 6.0, 4.0};
+
+    size_t exact_evaluations = 0;
+
+    auto ptc = ompl::base::plannerNonTerminatingCondition();
+
+    TspOptions options {TspSolver::LOCAL_SEARCH};
+    options.exact_threshold = 0;
+
+    auto ordering = tsp_open_end_grouped_lazy([&](auto i) {
+        return points[i.first];
+    }, [&](auto i, auto j) {
+        ++exact_evaluations;
+        return std::abs(points[i.first] - points[j.first]);
+    }, [&](auto i, auto j) {
+        return 0.5 * std::abs(points[i.first] - points[j.first]);
+    }, std::vector<size_t>(points.size(), 1), ptc, options);
+
+    std::vector<std::pair<size_t, size_t>> expected = {{3, 0}, {1, 0}, {5, 0}, {7, 0}, {2, 0}, {6, 0}, {0, 0}, {4, 0}};
+
+    EXPECT_EQ(ordering, expected);
+    EXPECT_LT(exact_evaluations, points.size() * (points.size() - 1) / 2);
+}
+
+TEST(TSPTEST, packed_symmetric_matrix) {
+
+    const size_t n = 7;
+
+    PackedSymmetricMatrix<int32_t> matrix(n);
+
+    EXPECT_EQ(matrix.packed_size(), n * (n + 1) / 2);
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i; j < n; ++j) {
+            matrix.set(j, i, (int32_t) (i * n + j));
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            EXPECT_EQ(matrix(i, j), (int32_t) (std::min(i, j) * n + std::max(i, j)));
+        }
+    }
+}
+
+TEST(TSPTEST, sparse_points_on_a_line) {
+
+    const size_t n = 50;
+
+    // Points on a line, in a shuffled order.
+    std::vector<Eigen::Vector3d> positions;
+    for (size_t i = 0; i < n; ++i) {
+        positions.emplace_back((double) ((i * 17) % n) + 1.0, 0.0, 0.0);
+    }
+
+    TspOptions options;
+    options.sparse_neighbours = 4;
+
+    auto ordering = tsp_open_end_sparse(Eigen::Vector3d::Zero(), positions, [&](size_t i) {
+        return positions[i].norm();
+    }, [&](size_t i, size_t j) {
+        return (positions[i] - positions[j]).norm();
+    }, ompl::base::plannerNonTerminatingCondition(), options);
+
+    ASSERT_EQ(ordering.size(), n);
+
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(positions[ordering[i]].x(), (double) i + 1.0);
+    }
+}
+
+TEST(TSPTEST, hierarchical_visits_everything_at_small_cost) {
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> coordinate(0.0, 10.0);
+
+    std::vector<Eigen::Vector3d> points(200);
+    for (auto &point : points) {
+        point = {coordinate(rng), coordinate(rng), 0.0};
+    }
+
+    auto from_start = [&](size_t i) { return points[i].norm(); };
+    auto between = [&](size_t i, size_t j) { return (points[i] - points[j]).norm(); };
+
+    auto tour_length = [&](const std::vector<size_t> &tour) {
+        double length = from_start(tour[0]);
+        for (size_t i = 1; i < tour.size(); ++i) {
+            length += between(tour[i - 1], tour[i]);
+        }
+        return length;
+    };
+
+    TspOptions flat_options {TspSolver::LOCAL_SEARCH};
+    TspOptions hierarchical_options {TspSolver::LOCAL_SEARCH};
+    hierarchical_options.cluster_size = 25;
+
+    auto flat = tsp_open_end(from_start, between, points.size(), ompl::base::plannerNonTerminatingCondition(), flat_options);
+    auto hierarchical = tsp_open_end_hierarchical(from_start, between, points.size(), ompl::base::plannerNonTerminatingCondition(), hierarchical_options);
+
+    auto sorted = hierarchical;
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_EQ(sorted, index_vector(points));
+
+    EXPECT_LT(tour_length(hierarchical), 1.25 * tour_length(flat));
+}
+
+TEST(TSPTEST, exact_matches_brute_force) {
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> coordinate(0.0, 10.0);
+
+    std::vector<Eigen::Vector3d> points(8);
+    for (auto &point : points) {
+        point = {coordinate(rng), coordinate(rng), 0.0};
+    }
+
+    auto problem = GroupedOpenTsp::build([&](size_t i) {
+        return points[i].norm();
+    }, [&](size_t i, size_t j) {
+        return (points[i] - points[j]).norm();
+    }, std::vector<size_t>(points.size(), 1), ompl::base::plannerNonTerminatingCondition());
+
+    auto tour = solve_open_tsp_exact(problem, ompl::base::plannerNonTerminatingCondition());
+
+    auto sorted = tour;
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_EQ(sorted, index_vector(points));
+
+    auto permutation = index_vector(points);
+    double best = std::numeric_limits<double>::infinity();
+    do {
+        best = std::min(best, open_tour_length(problem, permutation));
+    } while (std::next_permutation(permutation.begin(), permutation.end()));
+
+    EXPECT_NEAR(open_tour_length(problem, tour), best, 1e-4);
+}
+
+TEST(TSPTEST, small_problems_dispatch_to_exact) {
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> coordinate(0.0, 10.0);
+
+    std::vector<Eigen::Vector3d> points(7);
+    for (auto &point : points) {
+        point = {coordinate(rng), coordinate(rng), 0.0};
+    }
+
+    auto problem = GroupedOpenTsp::build([&](size_t i) {
+        return points[i].norm();
+    }, [&](size_t i, size_t j) {
+        return (points[i] - points[j]).norm();
+    }, std::vector<size_t>(points.size(), 1), ompl::base::plannerNonTerminatingCondition());
+
+    auto ptc = ompl::base::plannerNonTerminatingCondition();
+
+    TspOptions options {TspSolver::LOCAL_SEARCH};
+    ASSERT_GE(options.exact_threshold, points.size());
+
+    // Whichever solver is selected, problems under the threshold get the exact solution.
+    EXPECT_EQ(solve_open_tsp(problem, ptc, options), solve_open_tsp_exact(problem, ptc));
+}
+
+/// Memo item hashes for points on the X axis.
+std::vector<size_t> memo_items(const std::vector<double> &xs) {
+    std::vector<size_t> hashes;
+    for (double x : xs) {
+        hashes.push_back(TspMemo::hashPosition({x, 0.0, 0.0}));
+    }
+    return hashes;
+}
+
+TEST(TSPTEST, memo_lookup_is_independent_of_item_order) {
+
+    TspMemo memo;
+
+    const Eigen::Vector3d start(0.0, 0.0, 0.0);
+    const TspOptions options;
+
+    auto items = memo_items({1.0, 2.0, 3.0, 4.0});
+    TspMemo::Key key {TspMemo::hashGoalSet(start, items), "euclidean", options.memoKey()};
+
+    memo.store(key, items, {2, 0, 3, 1});
+
+    // The same items in a different order: same key, and the ordering visits the same items.
+    auto shuffled = memo_items({4.0, 3.0, 1.0, 2.0});
+    TspMemo::Key shuffled_key {TspMemo::hashGoalSet(start, shuffled), "euclidean", options.memoKey()};
+    ASSERT_EQ(shuffled_key.toString(), key.toString());
+
+    auto ordering = memo.lookup(shuffled_key, shuffled);
+    ASSERT_TRUE(ordering);
+    EXPECT_EQ(*ordering, std::vector<size_t>({1, 2, 0, 3}));
+
+    // Other solver options may find a different ordering, so they miss.
+    TspOptions other_options;
+    other_options.solver = TspSolver::LOCAL_SEARCH;
+    EXPECT_FALSE(memo.lookup({key.goal_set_hash, key.heuristic, other_options.memoKey()}, items));
+
+    // As do other heuristics, and other starts.
+    EXPECT_FALSE(memo.lookup({key.goal_set_hash, "shell", key.options}, items));
+    EXPECT_FALSE(memo.lookup({TspMemo::hashGoalSet({1.0, 0.0, 0.0}, items), key.heuristic, key.options}, items));
+
+    auto stats = memo.statistics();
+    EXPECT_EQ(stats["hits"].asUInt64(), 1);
+    EXPECT_EQ(stats["misses"].asUInt64(), 3);
+}
+
+TEST(TSPTEST, memo_keeps_interrupted_solves_as_warm_start_only) {
+
+    TspMemo memo;
+
+    const TspOptions options;
+
+    auto items = memo_items({1.0, 2.0, 3.0});
+    TspMemo::Key key {TspMemo::hashGoalSet({0.0, 0.0, 0.0}, items), "euclidean", options.memoKey()};
+
+    memo.store(key, items, {1, 0, 2}, false);
+
+    EXPECT_FALSE(memo.lookup(key, items));
+    EXPECT_EQ(memo.warmStart("euclidean", items), std::vector<size_t>({1, 0, 2}));
+}
+
+TEST(TSPTEST, memo_warm_start_translates_added_and_removed_items) {
+
+    TspMemo memo;
+
+    const TspOptions options;
+
+    // Visit 1.0, 2.0, 3.0, 4.0 in that order.
+    auto items = memo_items({3.0, 1.0, 4.0, 2.0});
+    memo.store({TspMemo::hashGoalSet({0.0, 0.0, 0.0}, items), "euclidean", options.memoKey()}, items, {1, 3, 0, 2});
+
+    // Remove 3.0 and add 5.0: the warm start keeps the order of the items that are left, and leaves out the new one.
+    auto changed = memo_items({5.0, 4.0, 2.0, 1.0});
+    EXPECT_EQ(memo.warmStart("euclidean", changed), std::vector<size_t>({3, 2, 1}));
+
+    // Nothing to start from with another heuristic.
+    EXPECT_TRUE(memo.warmStart("shell", changed).empty());
+}